@@ -0,0 +1,121 @@
+/// __________________________________________________
+/// transition-csv.cpp
+/// __________________________________________________
+///
+/// Standalone driver finding previous timepoints, previous results and transitions straight from a
+/// delimited text file, as read_transitions_csv() of package Transition, without R; reports the
+/// time spent parsing and sweeping and the rows per second. Output, if a path is given, is a
+/// columnar file as written by transition-stream, to be read from R by read_transition_file(); the
+/// parsing is documented in ../include/Transition/csv.h.
+///
+/// Build from this directory with e.g.
+///
+///   c++ -std=c++17 -O2 -pthread -I../include transition-csv.cpp -o transition-csv
+///
+/// and run as
+///
+///   transition-csv [--subject NAME] [--timepoint NAME] [--result NAME] [--levels A,B,...] [--delimiter C]
+///       [--cap N] [--modulate N] [--chunk MB] [--threads N] INPUT [OUTPUT]
+/// __________________________________________________
+
+#include <Transition/csv.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+int usage(const char* name)
+{
+	std::cerr << "Usage: " << name << " [--subject NAME] [--timepoint NAME] [--result NAME] [--levels A,B,...] [--delimiter C]\n"
+		<< "    [--cap N] [--modulate N] [--chunk MB] [--threads N] INPUT [OUTPUT]\n"
+		<< "  --subject NAME    column identifying subjects; default subject\n"
+		<< "  --timepoint NAME  column of dates, YYYY-MM-DD; default timepoint\n"
+		<< "  --result NAME     column of results; default result\n"
+		<< "  --levels A,B,...  results in order; default none, results being integers\n"
+		<< "  --delimiter C     field separator, or \"tab\"; default ,\n"
+		<< "  --cap N           cap on the magnitude of transitions; default 0, none\n"
+		<< "  --modulate N      divisor of transitions; default 0, none\n"
+		<< "  --chunk MB        text parsed at a time by each thread; default 16\n"
+		<< "  --threads N       threads parsing and sweeping; default 1\n";
+	return 2;
+}
+
+// Previous timepoints, previous results and transitions written as a columnar output file
+void write_output(const std::string& path, const transition_csv::Table& table)
+{
+	using namespace transition_stream;
+	const uint64_t m { table.rows() };
+	MappedFile out(path, sizeof(Header) + 8 + block_bytes(output_columns, m));
+	Header h { new_header(output_columns) };
+	h.nrows = m;
+	h.nblocks = 1;
+	std::memcpy(out.data(), &h, sizeof h);
+	std::memcpy(out.data() + sizeof h, &m, 8);
+	const Block cols { m, out.data() + sizeof h + 8 };
+	if (m) {
+		std::memcpy(const_cast<double*>(cols.prev_date()), table.prev_date.data(), 8 * m);
+		std::memcpy(const_cast<int32_t*>(cols.prev_result()), table.prev_result.data(), 4 * m);
+		std::memcpy(const_cast<int32_t*>(cols.transition()), table.transition.data(), 4 * m);
+	}
+}
+
+}	// namespace
+
+int main(int argc, char* argv[])
+{
+	transition_csv::Options opt;
+	std::string paths[2];
+	int npaths { 0 };
+	for (int a { 1 }; a < argc; ++a) {
+		const std::string arg { argv[a] };
+		if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+			if (a + 1 == argc)
+				return usage(argv[0]);
+			const std::string value { argv[++a] };
+			if (arg == "--subject")
+				opt.subject = value;
+			else if (arg == "--timepoint")
+				opt.timepoint = value;
+			else if (arg == "--result")
+				opt.result = value;
+			else if (arg == "--levels")
+				for (size_t b { 0 }, e; b <= value.size(); b = e + 1) {
+					e = std::min(value.find(',', b), value.size());
+					opt.levels.push_back(value.substr(b, e - b));
+				}
+			else if (arg == "--delimiter" && (value == "tab" || value.size() == 1))
+				opt.delimiter = value == "tab" ? '\t' : value[0];
+			else if (arg == "--cap")
+				opt.cap = std::atoi(value.c_str());
+			else if (arg == "--modulate")
+				opt.modulate = std::atoi(value.c_str());
+			else if (arg == "--chunk")
+				opt.chunk = uint64_t(std::atof(value.c_str()) * 1048576.0);
+			else if (arg == "--threads")
+				opt.threads = std::atoi(value.c_str());
+			else
+				return usage(argv[0]);
+		} else if (npaths < 2)
+			paths[npaths++] = arg;
+		else
+			return usage(argv[0]);
+	}
+	if (npaths < 1)
+		return usage(argv[0]);
+
+	try {
+		const transition_csv::Table table { transition_csv::read_transitions(paths[0], opt) };
+		const double seconds { table.parse_seconds + table.sweep_seconds };
+		std::cout << table.rows() << " rows of " << table.subjects.size() << " subjects in " << table.chunks << " chunks, "
+			<< table.parse_seconds << " s parsing, " << table.sweep_seconds << " s sweeping, "
+			<< (seconds > 0 ? table.rows() / seconds : 0) << " rows/s\n";
+		if (npaths == 2)
+			write_output(paths[1], table);
+	} catch (std::exception& e) {
+		std::cerr << "Error: " << e.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
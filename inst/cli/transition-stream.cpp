@@ -0,0 +1,83 @@
+/// __________________________________________________
+/// transition-stream.cpp
+/// __________________________________________________
+///
+/// Standalone driver finding previous timepoints, previous results and transitions of a columnar
+/// file of any size, as stream_transitions() of package Transition, without R. Input files may be
+/// written from R by write_transition_file(), and output read back by read_transition_file(); the
+/// layout of both is documented in ../include/Transition/stream.h.
+///
+/// Build from this directory with e.g.
+///
+///   c++ -std=c++17 -O2 -pthread -I../include transition-stream.cpp -o transition-stream
+///
+/// and run as
+///
+///   transition-stream [--cap N] [--modulate N] [--memory MB] [--threads N] [--tmpdir DIR] INPUT OUTPUT
+/// __________________________________________________
+
+#include <Transition/stream.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+int usage(const char* name)
+{
+	std::cerr << "Usage: " << name << " [--cap N] [--modulate N] [--memory MB] [--threads N] [--tmpdir DIR] INPUT OUTPUT\n"
+		<< "  --cap N        cap on the magnitude of transitions; default 0, none\n"
+		<< "  --modulate N   divisor of transitions; default 0, none\n"
+		<< "  --memory MB    memory for records held at once; default 256\n"
+		<< "  --threads N    threads sweeping partitions; default 1\n"
+		<< "  --tmpdir DIR   directory for temporary partition files; default .\n";
+	return 2;
+}
+
+}	// namespace
+
+int main(int argc, char* argv[])
+{
+	transition_stream::Options opt;
+	std::string paths[2];
+	int npaths { 0 };
+	for (int a { 1 }; a < argc; ++a) {
+		const std::string arg { argv[a] };
+		if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+			if (a + 1 == argc)
+				return usage(argv[0]);
+			const char* value { argv[++a] };
+			if (arg == "--cap")
+				opt.cap = std::atoi(value);
+			else if (arg == "--modulate")
+				opt.modulate = std::atoi(value);
+			else if (arg == "--memory")
+				opt.memory = uint64_t(std::atof(value) * 1048576.0);
+			else if (arg == "--threads")
+				opt.threads = std::atoi(value);
+			else if (arg == "--tmpdir")
+				opt.tmpdir = value;
+			else
+				return usage(argv[0]);
+		} else if (npaths < 2)
+			paths[npaths++] = arg;
+		else
+			return usage(argv[0]);
+	}
+	if (npaths != 2)
+		return usage(argv[0]);
+
+	try {
+		const auto start { std::chrono::steady_clock::now() };
+		const transition_stream::Summary summary { transition_stream::stream_transitions(paths[0], paths[1], opt) };
+		const double seconds { std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+		std::cout << summary.rows << " rows in " << summary.partitions << " partitions, " << seconds << " s, "
+			<< (seconds > 0 ? summary.rows / seconds : 0) << " rows/s\n";
+	} catch (std::exception& e) {
+		std::cerr << "Error: " << e.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
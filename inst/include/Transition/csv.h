@@ -0,0 +1,554 @@
+/// __________________________________________________
+/// Transition/csv.h
+/// __________________________________________________
+///
+/// Transitions straight from a delimited text file, header-only and independent of R so that it
+/// serves both the package and the standalone driver in inst/cli.
+///
+/// The file is memory-mapped and cut into chunks at line ends. Chunks are parsed on worker threads,
+/// reading only the subject, timepoint and result fields of each line: subjects are encoded against
+/// a dictionary of the chunk, ISO 8601 dates ("2024-03-01") converted directly to days since
+/// 1970-01-01, and results to integers or to their position in a given set of levels. Meanwhile the
+/// calling thread merges chunks in order, mapping each chunk's dictionary into the global one, so
+/// subject codes run 1, 2, ... in order of first appearance, and scatters the rows of each chunk into
+/// runs by a hash of subject, each bucket of runs holding whole subjects. The workers sort each
+/// chunk's runs as soon as it is merged, alongside parsing later chunks. Once the last chunk is
+/// merged and sorted, the sorted runs of each bucket are merged and swept on all threads by the
+/// rules of sweep.h.
+///
+/// Fields may be quoted, with "" for a quote within them, but quoted fields may not contain line
+/// breaks. Empty fields and NA are missing.
+/// __________________________________________________
+
+#ifndef TRANSITION_CSV_H
+#define TRANSITION_CSV_H
+
+#include <Transition/stream.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace transition_csv {
+
+using transition_sweep::na_integer;
+using transition_sweep::na_real;
+using transition_sweep::Record;
+
+struct Options {
+	std::string subject { "subject" }, timepoint { "timepoint" }, result { "result" };
+	std::vector<std::string> levels;	// results in order, or none for integer results
+	char delimiter { ',' };
+	uint64_t chunk { uint64_t(16) << 20 };	// bytes of text per chunk
+	int threads { 1 };
+	int cap { 0 }, modulate { 0 };
+};
+
+// Rows in file order, with subjects as codes into the dictionary of subjects
+struct Table {
+	std::vector<std::string> subjects;
+	std::vector<int32_t> subject, result, prev_result, transition;
+	std::vector<double> timepoint, prev_date;
+	int chunks { 0 };
+	double parse_seconds { 0 }, sweep_seconds { 0 };
+	uint64_t rows() const { return subject.size(); }
+};
+
+
+/// __________________________________________________
+/// Fields
+
+struct Field {
+	const char* begin;
+	const char* end;
+	bool escaped;	// quoted, with "" to be undoubled
+};
+
+// Text of field, undoubling quotes if need be into store
+inline std::string_view text(const Field& f, std::string& store)
+{
+	if (!f.escaped)
+		return std::string_view(f.begin, f.end - f.begin);
+	store.clear();
+	for (const char* p { f.begin }; p < f.end; ++p) {
+		store.push_back(*p);
+		if (*p == '"')
+			++p;
+	}
+	return store;
+}
+
+inline bool missing(std::string_view s) { return s.empty() || s == "NA"; }
+
+// Fields of the line starting at p, stored up to column last; p is left at the start of the next
+// line. Returns the number of fields, or -1 if a quote is not closed before the end of the line
+inline int split_line(const char*& p, const char* end, char delim, int last, Field* out)
+{
+	int col { 0 };
+	for (;;) {
+		Field f { p, p, false };
+		if (p < end && *p == '"') {
+			f.begin = ++p;
+			for (;; ++p) {
+				if (p == end || *p == '\n')
+					return -1;
+				if (*p == '"') {
+					if (p + 1 < end && p[1] == '"') {
+						f.escaped = true;
+						++p;
+					} else
+						break;
+				}
+			}
+			f.end = p++;
+			while (p < end && *p != delim && *p != '\n')
+				++p;
+		} else {
+			while (p < end && *p != delim && *p != '\n')
+				++p;
+			f.end = (p > f.begin && p[-1] == '\r' && (p == end || *p == '\n')) ? p - 1 : p;
+		}
+		if (col <= last)
+			out[col] = f;
+		++col;
+		if (p < end && *p == delim) {
+			++p;
+			continue;
+		}
+		if (p < end)
+			++p;
+		return col;
+	}
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date
+inline int64_t days_from_civil(int64_t y, unsigned m, unsigned d)
+{
+	y -= m <= 2;
+	const int64_t era { (y >= 0 ? y : y - 399) / 400 };
+	const unsigned yoe { unsigned(y - era * 400) };
+	const unsigned doy { (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1 };
+	const unsigned doe { yoe * 365 + yoe / 4 - yoe / 100 + doy };
+	return era * 146097 + int64_t(doe) - 719468;
+}
+
+// Day number of "YYYY-MM-DD", or false if the text is not such a date
+inline bool parse_date(std::string_view s, double& day)
+{
+	if (s.size() != 10 || s[4] != '-' || s[7] != '-')
+		return false;
+	int v[8];
+	for (int k { 0 }, j { 0 }; k < 10; ++k)
+		if (k != 4 && k != 7) {
+			if (s[k] < '0' || s[k] > '9')
+				return false;
+			v[j++] = s[k] - '0';
+		}
+	const int y { v[0] * 1000 + v[1] * 100 + v[2] * 10 + v[3] }, m { v[4] * 10 + v[5] }, d { v[6] * 10 + v[7] };
+	static constexpr int month_days[12] { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	const bool leap { (y % 4 == 0 && y % 100 != 0) || y % 400 == 0 };
+	if (m < 1 || m > 12 || d < 1 || d > month_days[m - 1] || (m == 2 && d == 29 && !leap))
+		return false;
+	day = double(days_from_civil(y, m, d));
+	return true;
+}
+
+// Integer of optionally signed decimal digits, or false if out of range or not such an integer
+inline bool parse_int(std::string_view s, int32_t& value)
+{
+	size_t k { s.size() && (s[0] == '-' || s[0] == '+') ? size_t(1) : 0 };
+	if (k == s.size())
+		return false;
+	int64_t v { 0 };
+	for (; k < s.size(); ++k) {
+		if (s[k] < '0' || s[k] > '9' || v > INT32_MAX)
+			return false;
+		v = v * 10 + (s[k] - '0');
+	}
+	v = s[0] == '-' ? -v : v;
+	if (v <= INT32_MIN || v > INT32_MAX)
+		return false;
+	value = int32_t(v);
+	return true;
+}
+
+
+/// __________________________________________________
+/// Dictionary of strings coded 1, 2, ... in order of first insertion, by open addressing; the
+/// strings themselves are held elsewhere
+
+class Dictionary {
+	struct Slot {
+		uint32_t check;	// high bits of the hash, compared before the string
+		int32_t code;	// or 0 if empty
+	};
+	std::vector<std::string_view> names;
+	std::vector<uint64_t> hashes;
+	std::vector<Slot> slots { std::vector<Slot>(64, Slot { 0, 0 }) };
+	uint64_t mask { 63 };
+
+	static uint64_t hash(std::string_view s)
+	{
+		uint64_t h { 14695981039346656037ULL };
+		for (const unsigned char c : s)
+			h = (h ^ c) * 1099511628211ULL;
+		return h ^ (h >> 29);
+	}
+
+	void grow()
+	{
+		slots.assign(slots.size() * 2, Slot { 0, 0 });
+		mask = slots.size() - 1;
+		for (size_t k { 0 }; k < names.size(); ++k) {
+			uint64_t at { hashes[k] & mask };
+			while (slots[at].code)
+				at = (at + 1) & mask;
+			slots[at] = Slot { uint32_t(hashes[k] >> 32), int32_t(k + 1) };
+		}
+	}
+
+public:
+	// Code of s, and whether it was inserted as a new string
+	std::pair<int32_t, bool> insert(std::string_view s)
+	{
+		const uint64_t h { hash(s) };
+		uint64_t at { h & mask };
+		for (; slots[at].code; at = (at + 1) & mask)
+			if (slots[at].check == uint32_t(h >> 32) && names[slots[at].code - 1] == s)
+				return { slots[at].code, false };
+		names.push_back(s);
+		hashes.push_back(h);
+		slots[at] = Slot { uint32_t(h >> 32), int32_t(names.size()) };
+		if (2 * names.size() > slots.size())
+			grow();
+		return { int32_t(names.size()), true };
+	}
+
+	// String of code replaced by an equal one held elsewhere
+	void rename(int32_t code, std::string_view s) { names[code - 1] = s; }
+
+	// Strings in order of their codes
+	const std::vector<std::string_view>& strings() const { return names; }
+	size_t size() const { return names.size(); }
+};
+
+
+/// __________________________________________________
+/// Chunks
+
+// Rows of a chunk, subjects coded 1, 2, ... into its own dictionary in order of first appearance
+struct Chunk {
+	const char* begin;
+	const char* end;
+	std::deque<std::string> unquoted;	// stable storage of undoubled subjects
+	Dictionary names;
+	std::vector<int32_t> subject, result;
+	std::vector<double> timepoint;
+	std::string error;
+	const char* where { nullptr };
+	bool ready { false };
+};
+
+struct Columns {
+	int subject, timepoint, result, last;
+};
+
+inline void parse_chunk(Chunk& c, const Columns& cols, const Options& opt,
+	const std::unordered_map<std::string_view, int32_t>& levels)
+{
+	std::vector<Field> fields(cols.last + 1);
+	std::string store;
+	const auto fail = [&c](const char* where, std::string what) { c.where = where; c.error = std::move(what); };
+	for (const char* p { c.begin }; p < c.end; ) {
+		const char* line { p };
+		if (*p == '\n' || (*p == '\r' && p + 1 < c.end && p[1] == '\n')) {
+			p += *p == '\n' ? 1 : 2;
+			continue;
+		}
+		const int n { split_line(p, c.end, opt.delimiter, cols.last, fields.data()) };
+		if (n < 0)
+			return fail(line, "quote not closed before end of line");
+		if (n <= cols.last)
+			return fail(line, "too few fields");
+
+		std::string_view s { text(fields[cols.subject], store) };
+		if (missing(s))
+			c.subject.push_back(na_integer);
+		else {
+			if (fields[cols.subject].escaped) {
+				c.unquoted.emplace_back(s);
+				s = c.unquoted.back();
+			}
+			c.subject.push_back(c.names.insert(s).first);
+		}
+
+		double day { na_real() };
+		s = text(fields[cols.timepoint], store);
+		if (!missing(s) && !parse_date(s, day))
+			return fail(line, "timepoint \"" + std::string(s) + "\" not a date of form YYYY-MM-DD");
+		c.timepoint.push_back(day);
+
+		int32_t res { na_integer };
+		s = text(fields[cols.result], store);
+		if (!missing(s)) {
+			if (levels.empty()) {
+				if (!parse_int(s, res))
+					return fail(line, "result \"" + std::string(s) + "\" not an integer");
+			} else {
+				const auto it { levels.find(s) };
+				if (it == levels.end())
+					return fail(line, "result \"" + std::string(s) + "\" not one of the levels");
+				res = it->second;
+			}
+		}
+		c.result.push_back(res);
+	}
+}
+
+
+/// __________________________________________________
+/// Transitions
+
+// Table of transitions of the delimited text file at path. Chunks are parsed on opt.threads - 1
+// worker threads while the calling thread merges them and the workers sort the runs of those merged,
+// or all on the calling thread if opt.threads is 1; at most a few chunks per worker are held parsed
+// but not yet merged
+inline Table read_transitions(const std::string& path, const Options& opt)
+{
+	if (opt.cap < 0 || opt.modulate < 0)
+		throw std::invalid_argument("\"cap\" or \"modulate\" less than zero");
+	if (opt.threads < 1)
+		throw std::invalid_argument("\"threads\" less than one");
+	if (opt.delimiter == '"' || opt.delimiter == '\n' || opt.delimiter == '\r')
+		throw std::invalid_argument("\"delimiter\" not a field separator");
+	const auto start { std::chrono::steady_clock::now() };
+	const transition_stream::MappedFile map(path);
+	const char* data { reinterpret_cast<const char*>(map.data()) };
+	const char* const end { data + map.size() };
+	if (map.size() >= 3 && !std::memcmp(data, "\xEF\xBB\xBF", 3))
+		data += 3;
+
+	// Columns located by name in the first line, once counted
+	const char* p { data };
+	const int ncol { split_line(p, end, opt.delimiter, -1, nullptr) };
+	if (ncol < 0)
+		throw std::invalid_argument("\"" + path + "\" has a quote not closed in its first line");
+	std::vector<Field> header(ncol);
+	p = data;
+	split_line(p, end, opt.delimiter, ncol - 1, header.data());
+	std::string store;
+	const auto column = [&](const std::string& name) {
+		for (int k { 0 }; k < ncol; ++k)
+			if (text(header[k], store) == name)
+				return k;
+		throw std::invalid_argument("column \"" + name + "\" not found in \"" + path + "\"");
+	};
+	Columns cols { column(opt.subject), column(opt.timepoint), column(opt.result), 0 };
+	cols.last = std::max({ cols.subject, cols.timepoint, cols.result });
+	std::unordered_map<std::string_view, int32_t> levels;
+	for (size_t k { 0 }; k < opt.levels.size(); ++k)
+		if (!levels.emplace(opt.levels[k], int32_t(k + 1)).second)
+			throw std::invalid_argument("level \"" + opt.levels[k] + "\" duplicated");
+
+	// Chunks ending at line ends
+	std::deque<Chunk> chunks;
+	const uint64_t step { std::max<uint64_t>(opt.chunk, 1024) };
+	for (const char* b { p }; b < end; ) {
+		const char* e { end - b > ptrdiff_t(step) ? b + step : end };
+		if (e < end) {
+			const void* nl { std::memchr(e - 1, '\n', end - e + 1) };
+			e = nl ? static_cast<const char*>(nl) + 1 : end;
+		}
+		chunks.emplace_back();
+		chunks.back().begin = b;
+		chunks.back().end = e;
+		b = e;
+	}
+	const int nchunks { int(chunks.size()) };
+
+	Table table;
+	table.chunks = nchunks;
+	const int nbuckets { std::min(opt.threads * 4, transition_stream::max_partitions) };
+	std::vector<std::vector<std::vector<Record>>> runs(nchunks);	// of each chunk, by bucket
+	const auto sort_runs = [&](int k) {
+		for (auto& run : runs[k])
+			std::sort(run.begin(), run.end(), transition_sweep::record_order);
+	};
+	Dictionary dict;
+	std::deque<std::string> unquoted;	// subjects not found verbatim in the file
+	std::vector<int32_t> recode;
+
+	// Chunk k merged into the table, its subjects mapped into the global dictionary
+	const auto merge = [&](int k) {
+		Chunk& c { chunks[k] };
+		if (!c.error.empty()) {
+			const uint64_t line { 1 + uint64_t(std::count(reinterpret_cast<const char*>(map.data()), c.where, '\n')) };
+			throw std::invalid_argument("\"" + path + "\" line " + std::to_string(line) + ": " + c.error);
+		}
+		const auto& names { c.names.strings() };
+		recode.resize(names.size());
+		for (size_t x { 0 }; x < names.size(); ++x) {
+			const auto code { dict.insert(names[x]) };
+			if (code.second && (names[x].data() < data || names[x].data() >= end)) {
+				unquoted.emplace_back(names[x]);
+				dict.rename(code.first, unquoted.back());
+			}
+			recode[x] = code.first;
+		}
+		const int64_t first { int64_t(table.subject.size()) };
+		runs[k].resize(nbuckets);
+		for (size_t x { 0 }; x < c.subject.size(); ++x) {
+			if (std::isnan(c.timepoint[x]))
+				throw std::invalid_argument("missing timepoint in row " + std::to_string(first + int64_t(x) + 1));
+			const int32_t subject { na_integer == c.subject[x] ? na_integer : recode[c.subject[x] - 1] };
+			const int b { int((uint64_t(uint32_t(subject) * 2654435761u) * nbuckets) >> 32) };
+			runs[k][b].push_back(Record { first + int64_t(x), c.timepoint[x], subject, c.result[x] });
+			table.subject.push_back(subject);
+		}
+		table.timepoint.insert(table.timepoint.end(), c.timepoint.begin(), c.timepoint.end());
+		table.result.insert(table.result.end(), c.result.begin(), c.result.end());
+		if (table.subject.size() >= uint64_t(INT32_MAX))
+			throw std::invalid_argument("\"" + path + "\" has too many rows");
+		c = Chunk();
+	};
+
+	const int workers { opt.threads - 1 };
+	if (!workers)
+		for (int k { 0 }; k < nchunks; ++k) {
+			parse_chunk(chunks[k], cols, opt, levels);
+			merge(k);
+			sort_runs(k);
+		}
+	else {
+		// Workers sort the runs of merged chunks first, otherwise parse the next chunk within the window
+		std::mutex mutex;
+		std::condition_variable cv;
+		int next { 0 }, merged { 0 }, sorted { 0 };
+		bool stop { false };
+		std::exception_ptr failed;
+		const int window { 2 * workers + 2 };
+		auto work = [&]() {
+			for (;;) {
+				int k;
+				bool sort;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					cv.wait(lock, [&]() { return stop || sorted < merged || merged == nchunks || (next < nchunks && next < merged + window); });
+					if (stop || (sorted == nchunks))
+						return;
+					if (!(sort = sorted < merged) && !(next < nchunks && next < merged + window))
+						continue;
+					k = sort ? sorted++ : next++;
+				}
+				if (sort) {
+					try {
+						sort_runs(k);
+					} catch (...) {
+						std::lock_guard<std::mutex> lock(mutex);
+						failed = std::current_exception();
+						stop = true;
+						cv.notify_all();
+						return;
+					}
+					continue;
+				}
+				try {
+					parse_chunk(chunks[k], cols, opt, levels);
+				} catch (std::exception& e) {
+					chunks[k].where = chunks[k].begin;
+					chunks[k].error = e.what();
+				}
+				std::lock_guard<std::mutex> lock(mutex);
+				chunks[k].ready = true;
+				cv.notify_all();
+			}
+		};
+		std::vector<std::thread> pool;
+		for (int t { 0 }; t < workers; ++t)
+			pool.emplace_back(work);
+		std::exception_ptr error;
+		try {
+			for (int k { 0 }; k < nchunks; ++k) {
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					cv.wait(lock, [&]() { return stop || chunks[k].ready; });
+					if (stop)
+						break;
+				}
+				merge(k);
+				std::lock_guard<std::mutex> lock(mutex);
+				merged = k + 1;
+				cv.notify_all();
+			}
+		} catch (...) {
+			error = std::current_exception();
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+			cv.notify_all();
+		}
+		for (auto& th : pool)
+			th.join();
+		if (!error)
+			error = failed;
+		if (error)
+			std::rethrow_exception(error);
+	}
+	table.subjects.assign(dict.strings().begin(), dict.strings().end());
+	const auto parsed { std::chrono::steady_clock::now() };
+	table.parse_seconds = std::chrono::duration<double>(parsed - start).count();
+
+	// Sorted runs of each bucket of whole subjects merged pairwise and swept, each bucket taken in turn
+	// by the next free thread
+	const uint64_t n { table.rows() };
+	table.prev_date.resize(n);
+	table.prev_result.resize(n);
+	table.transition.resize(n);
+	std::atomic<int> bucket { 0 };
+	std::vector<std::exception_ptr> errors(opt.threads);
+	auto sweep = [&](int t) {
+		try {
+			for (int b; (b = bucket++) < nbuckets; ) {
+				size_t total { 0 };
+				for (const auto& chunk : runs)
+					total += chunk[b].size();
+				std::vector<Record> recs;
+				recs.reserve(total);
+				std::vector<size_t> bounds { 0 };
+				for (auto& chunk : runs)
+					if (!chunk[b].empty()) {
+						recs.insert(recs.end(), chunk[b].begin(), chunk[b].end());
+						std::vector<Record>().swap(chunk[b]);
+						bounds.push_back(recs.size());
+					}
+				const size_t nruns { bounds.size() - 1 };
+				for (size_t width { 1 }; width < nruns; width *= 2)
+					for (size_t r { 0 }; r + width < nruns; r += 2 * width)
+						std::inplace_merge(recs.begin() + bounds[r], recs.begin() + bounds[r + width],
+							recs.begin() + bounds[std::min(r + 2 * width, nruns)], transition_sweep::record_order);
+				transition_sweep::sweep_sorted(recs, table.prev_date.data(), table.prev_result.data(), table.transition.data(),
+					opt.cap, opt.modulate);
+			}
+		} catch (...) {
+			errors[t] = std::current_exception();
+			bucket = nbuckets;
+		}
+	};
+	std::vector<std::thread> pool;
+	for (int t { 1 }; t < opt.threads; ++t)
+		pool.emplace_back(sweep, t);
+	sweep(0);
+	for (auto& th : pool)
+		th.join();
+	for (auto& e : errors)
+		if (e)
+			std::rethrow_exception(e);
+	table.sweep_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - parsed).count();
+	return table;
+}
+
+}	// namespace transition_csv
+
+#endif  // TRANSITION_CSV_H
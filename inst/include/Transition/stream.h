@@ -0,0 +1,580 @@
+/// __________________________________________________
+/// Transition/stream.h
+/// __________________________________________________
+///
+/// Out-of-core transitions over a memory-mapped columnar file, header-only and independent of R so
+/// that it serves both the package and the standalone driver in inst/cli.
+///
+/// File layout, all values little-endian:
+///
+///   header, 32 bytes:
+///     0   char[8]   magic "TRANSCOL"
+///     8   uint32    version, 1
+///     12  uint32    kind, 0 for input columns or 1 for output columns
+///     16  uint64    total number of rows
+///     24  uint32    number of blocks
+///     28  uint32    reserved, 0
+///
+///   blocks, one after another, each of m rows:
+///     uint64 m, then for input
+///       int32[m] subject, padded to a multiple of 8 bytes
+///       double[m] timepoint
+///       int32[m] result, padded to a multiple of 8 bytes
+///     or for output
+///       double[m] previous timepoint
+///       int32[m] previous result
+///       int32[m] transition, padded to a multiple of 8 bytes
+///
+/// Missing values are those of R: NA_integer_ is INT32_MIN and NA_real_ the NaN with low word 1954.
+/// Input may be appended a block at a time, and is read in place; output is a single block in the
+/// order of the input rows.
+/// __________________________________________________
+
+#ifndef TRANSITION_STREAM_H
+#define TRANSITION_STREAM_H
+
+#include <Transition/sweep.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace transition_stream {
+
+using transition_sweep::na_integer;
+using transition_sweep::na_real;
+using transition_sweep::Record;
+using transition_sweep::sweep_records;
+
+/// __________________________________________________
+/// Layout
+
+constexpr char magic[8] { 'T', 'R', 'A', 'N', 'S', 'C', 'O', 'L' };
+constexpr uint32_t version { 1 };
+enum Kind : uint32_t { input_columns = 0, output_columns = 1 };
+
+struct Header {
+	char magic[8];
+	uint32_t version, kind;
+	uint64_t nrows;
+	uint32_t nblocks, reserved;
+};
+static_assert(sizeof(Header) == 32, "Header must be 32 bytes");
+
+inline bool little_endian()
+{
+	const uint16_t one { 1 };
+	unsigned char first;
+	std::memcpy(&first, &one, 1);
+	return first == 1;
+}
+
+inline uint64_t padded(uint64_t bytes) { return (bytes + 7) & ~uint64_t(7); }
+
+// Bytes of a block of m rows, following its row count
+inline uint64_t block_bytes(Kind kind, uint64_t m)
+{
+	return kind == input_columns ? padded(4 * m) + 8 * m + padded(4 * m) : 8 * m + 4 * m + padded(4 * m);
+}
+
+inline Header new_header(Kind kind)
+{
+	Header h {};
+	std::memcpy(h.magic, magic, sizeof magic);
+	h.version = version;
+	h.kind = kind;
+	return h;
+}
+
+inline void check_header(const Header& h, const std::string& path)
+{
+	if (std::memcmp(h.magic, magic, sizeof magic))
+		throw std::invalid_argument("\"" + path + "\" is not a columnar transition file");
+	if (h.version != version)
+		throw std::invalid_argument("\"" + path + "\" has unsupported version " + std::to_string(h.version));
+	if (h.kind != input_columns && h.kind != output_columns)
+		throw std::invalid_argument("\"" + path + "\" has unknown kind " + std::to_string(h.kind));
+}
+
+
+/// __________________________________________________
+/// Mapping of a whole file into memory, read-only, or created read-write at a given size
+
+class MappedFile {
+	unsigned char* base { nullptr };
+	uint64_t len { 0 };
+#ifdef _WIN32
+	HANDLE file { INVALID_HANDLE_VALUE }, mapping { NULL };
+#endif
+
+	void map(const std::string& path, bool writable, uint64_t size)
+	{
+#ifdef _WIN32
+		file = CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, NULL,
+			writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("cannot open \"" + path + "\"");
+		if (writable)
+			len = size;
+		else {
+			LARGE_INTEGER bytes;
+			if (!GetFileSizeEx(file, &bytes))
+				throw std::runtime_error("cannot size \"" + path + "\"");
+			len = uint64_t(bytes.QuadPart);
+		}
+		if (!len)
+			return;
+		mapping = CreateFileMappingA(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, DWORD(len >> 32), DWORD(len), NULL);
+		if (!mapping)
+			throw std::runtime_error("cannot map \"" + path + "\"");
+		base = static_cast<unsigned char*>(MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+		if (!base)
+			throw std::runtime_error("cannot map \"" + path + "\"");
+#else
+		const int fd { ::open(path.c_str(), writable ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644) };
+		if (fd < 0)
+			throw std::runtime_error("cannot open \"" + path + "\"");
+		struct stat st;
+		if (writable ? ::ftruncate(fd, off_t(size)) != 0 : ::fstat(fd, &st) != 0) {
+			::close(fd);
+			throw std::runtime_error("cannot size \"" + path + "\"");
+		}
+		len = writable ? size : uint64_t(st.st_size);
+		if (len) {
+			void* p { ::mmap(nullptr, len, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0) };
+			if (p == MAP_FAILED) {
+				::close(fd);
+				throw std::runtime_error("cannot map \"" + path + "\"");
+			}
+			base = static_cast<unsigned char*>(p);
+			if (!writable)
+				::madvise(p, len, MADV_SEQUENTIAL);
+		}
+		::close(fd);
+#endif
+	}
+
+public:
+	explicit MappedFile(const std::string& path) { map(path, false, 0); }
+	MappedFile(const std::string& path, uint64_t size) { map(path, true, size); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile()
+	{
+#ifdef _WIN32
+		if (base)
+			UnmapViewOfFile(base);
+		if (mapping)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+#else
+		if (base)
+			::munmap(base, len);
+#endif
+	}
+
+	unsigned char* data() const { return base; }
+	uint64_t size() const { return len; }
+};
+
+
+/// __________________________________________________
+/// Columnar file read in place, its blocks located and checked against the file size
+
+struct Block {
+	uint64_t rows;
+	const unsigned char* data;
+	const int32_t* subject() const { return reinterpret_cast<const int32_t*>(data); }
+	const double* timepoint() const { return reinterpret_cast<const double*>(data + padded(4 * rows)); }
+	const int32_t* result() const { return reinterpret_cast<const int32_t*>(data + padded(4 * rows) + 8 * rows); }
+	const double* prev_date() const { return reinterpret_cast<const double*>(data); }
+	const int32_t* prev_result() const { return reinterpret_cast<const int32_t*>(data + 8 * rows); }
+	const int32_t* transition() const { return reinterpret_cast<const int32_t*>(data + 12 * rows); }
+};
+
+class ColumnarFile {
+	MappedFile map;
+	Header head;
+	std::vector<Block> parts;
+public:
+	explicit ColumnarFile(const std::string& path) : map(path)
+	{
+		if (!little_endian())
+			throw std::runtime_error("columnar transition files need a little-endian platform");
+		if (map.size() < sizeof head)
+			throw std::invalid_argument("\"" + path + "\" is not a columnar transition file");
+		std::memcpy(&head, map.data(), sizeof head);
+		check_header(head, path);
+		uint64_t at { sizeof head }, rows { 0 };
+		for (uint32_t b { 0 }; b < head.nblocks; ++b) {
+			uint64_t m;
+			if (at + 8 > map.size())
+				throw std::invalid_argument("\"" + path + "\" is truncated");
+			std::memcpy(&m, map.data() + at, 8);
+			at += 8;
+			if (m > map.size() || at + block_bytes(Kind(head.kind), m) > map.size())
+				throw std::invalid_argument("\"" + path + "\" is truncated");
+			parts.push_back(Block { m, map.data() + at });
+			at += block_bytes(Kind(head.kind), m);
+			rows += m;
+		}
+		if (rows != head.nrows)
+			throw std::invalid_argument("\"" + path + "\" has blocks not adding up to its number of rows");
+	}
+
+	const Header& header() const { return head; }
+	Kind kind() const { return Kind(head.kind); }
+	uint64_t rows() const { return head.nrows; }
+	const std::vector<Block>& blocks() const { return parts; }
+};
+
+
+/// __________________________________________________
+/// Append a block of input rows to a columnar file, creating it unless appending to an existing one
+
+inline void append_block(const std::string& path, uint64_t m, const int32_t* subject, const double* timepoint, const int32_t* result,
+	bool append)
+{
+	if (!little_endian())
+		throw std::runtime_error("columnar transition files need a little-endian platform");
+	std::FILE* f { append ? std::fopen(path.c_str(), "r+b") : nullptr };
+	Header h { new_header(input_columns) };
+	if (f) {
+		if (std::fread(&h, sizeof h, 1, f) != 1) {
+			std::fclose(f);
+			throw std::invalid_argument("\"" + path + "\" is not a columnar transition file");
+		}
+		try {
+			check_header(h, path);
+			if (h.kind != input_columns)
+				throw std::invalid_argument("\"" + path + "\" is not an input file");
+		} catch (...) {
+			std::fclose(f);
+			throw;
+		}
+	} else if (!(f = std::fopen(path.c_str(), "w+b")) || std::fwrite(&h, sizeof h, 1, f) != 1) {
+		if (f)
+			std::fclose(f);
+		throw std::runtime_error("cannot create \"" + path + "\"");
+	}
+	const char zeros[8] {};
+	const auto put = [f](const void* p, size_t bytes) { return !bytes || std::fwrite(p, 1, bytes, f) == bytes; };
+	h.nrows += m;
+	++h.nblocks;
+	const bool good {
+		0 == std::fseek(f, 0, SEEK_END) && put(&m, 8)
+		&& put(subject, 4 * m) && put(zeros, padded(4 * m) - 4 * m)
+		&& put(timepoint, 8 * m)
+		&& put(result, 4 * m) && put(zeros, padded(4 * m) - 4 * m)
+		&& 0 == std::fseek(f, 0, SEEK_SET) && put(&h, sizeof h)
+	};
+	if (std::fclose(f) != 0 || !good)
+		throw std::runtime_error("cannot write \"" + path + "\"");
+}
+
+
+/// __________________________________________________
+/// Transitions
+
+struct Options {
+	int cap { 0 }, modulate { 0 };
+	uint64_t memory { uint64_t(256) << 20 };	// bytes of records held at once, shared among threads
+	int threads { 1 };
+	std::string tmpdir { "." };
+};
+
+struct Summary {
+	uint64_t rows { 0 };
+	int partitions { 0 };
+};
+
+constexpr int max_partitions { 256 };	// partition files open at once across threads, within usual descriptor limits
+constexpr int min_split { 16 };		// partitions into which one too large is split again
+constexpr int max_depth { 16 };		// times a partition may be split again
+
+// Partition of a subject among parts, by the murmur3 finaliser of the subject mixed with a seed, so
+// that subjects sharing a partition are spread afresh when it is split again with another seed
+inline int partition_of(int32_t subject, int parts, uint32_t seed)
+{
+	uint32_t h { uint32_t(subject) ^ seed * 0x9E3779B9u };
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+	return int((uint64_t(h) * parts) >> 32);
+}
+
+// Temporary partition files, open while written then closed until each is read, and removed however
+// the stream ends
+class Partitions {
+	std::vector<std::string> paths;
+	std::vector<std::FILE*> files;
+	std::vector<uint64_t> counts;
+	std::vector<int32_t> firsts;
+	std::vector<bool> mixed;
+
+	std::FILE* reopen(int k)
+	{
+		if (!(files[k] = std::fopen(paths[k].c_str(), "rb")))
+			throw std::runtime_error("cannot read temporary file \"" + paths[k] + "\"");
+		return files[k];
+	}
+
+	void done(int k)
+	{
+		std::fclose(files[k]);
+		files[k] = nullptr;
+		std::remove(paths[k].c_str());
+	}
+
+public:
+	Partitions(const std::string& dir, int n)
+	{
+		std::random_device rd;
+		const std::string stem { dir + "/transition-stream-" + std::to_string(rd()) + "-" };
+		for (int k { 0 }; k < n; ++k) {
+			paths.push_back(stem + std::to_string(k) + ".tmp");
+			files.push_back(std::fopen(paths.back().c_str(), "wb"));
+			if (!files.back()) {
+				// Not constructed, so those already created are closed and removed here
+				const std::string path { paths.back() };
+				for (int j { 0 }; j < k; ++j) {
+					std::fclose(files[j]);
+					std::remove(paths[j].c_str());
+				}
+				throw std::runtime_error("cannot create temporary file \"" + path + "\"");
+			}
+		}
+		counts.assign(n, 0);
+		firsts.assign(n, 0);
+		mixed.assign(n, false);
+	}
+	Partitions(const Partitions&) = delete;
+	Partitions& operator=(const Partitions&) = delete;
+	~Partitions()
+	{
+		for (size_t k { 0 }; k < files.size(); ++k) {
+			if (files[k])
+				std::fclose(files[k]);
+			std::remove(paths[k].c_str());
+		}
+	}
+
+	int size() const { return int(files.size()); }
+	uint64_t count(int k) const { return counts[k]; }
+	bool single_subject(int k) const { return !mixed[k]; }
+
+	void write(int k, const std::vector<Record>& recs)
+	{
+		if (std::fwrite(recs.data(), sizeof(Record), recs.size(), files[k]) != recs.size())
+			throw std::runtime_error("cannot write temporary file \"" + paths[k] + "\"");
+		if (!counts[k] && !recs.empty())
+			firsts[k] = recs.front().subject;
+		for (size_t x { 0 }; x < recs.size() && !mixed[k]; ++x)
+			mixed[k] = recs[x].subject != firsts[k];
+		counts[k] += recs.size();
+	}
+
+	// Close every file once all are written
+	void close()
+	{
+		for (size_t k { 0 }; k < files.size(); ++k) {
+			const bool good { !files[k] || std::fclose(files[k]) == 0 };
+			files[k] = nullptr;
+			if (!good)
+				throw std::runtime_error("cannot write temporary file \"" + paths[k] + "\"");
+		}
+	}
+
+	std::vector<Record> read(int k)
+	{
+		std::FILE* f { reopen(k) };
+		std::vector<Record> recs(counts[k]);
+		if (std::fread(recs.data(), sizeof(Record), recs.size(), f) != recs.size())
+			throw std::runtime_error("cannot read temporary file \"" + paths[k] + "\"");
+		done(k);
+		return recs;
+	}
+
+	// Records of partition k passed to f a piece of at most the given number at a time, after which
+	// the file is removed
+	template<class F>
+	void scan(int k, uint64_t piece, F f)
+	{
+		std::FILE* fp { reopen(k) };
+		std::vector<Record> recs;
+		for (uint64_t done { 0 }; done < counts[k]; done += recs.size()) {
+			recs.resize(size_t(std::min(piece, counts[k] - done)));
+			if (std::fread(recs.data(), sizeof(Record), recs.size(), fp) != recs.size())
+				throw std::runtime_error("cannot read temporary file \"" + paths[k] + "\"");
+			f(recs);
+		}
+		done(k);
+	}
+};
+
+// Scatter records to partitions by subject, through a buffer of the given number of records for each,
+// then close them
+template<class Source>
+void scatter(Partitions& files, size_t buffered, uint32_t seed, Source source)
+{
+	const int parts { files.size() };
+	std::vector<std::vector<Record>> buffers(parts);
+	for (auto& buffer : buffers)
+		buffer.reserve(buffered);
+	source([&](const Record& r) {
+		const int k { partition_of(r.subject, parts, seed) };
+		buffers[k].push_back(r);
+		if (buffers[k].size() == buffered) {
+			files.write(k, buffers[k]);
+			buffers[k].clear();
+		}
+	});
+	for (int k { 0 }; k < parts; ++k) {
+		files.write(k, buffers[k]);
+		std::vector<Record>().swap(buffers[k]);
+	}
+	files.close();
+}
+
+// Sweep partition k, first splitting it again by subject with the next seed, as often as needed,
+// while it holds more than per_partition records of more than one subject; returns the number of
+// partitions finally swept. Each split is into at most a thread's share of max_partitions, whose
+// files are closed before any is swept, so that at any depth a thread holds open only those of the
+// split being written and the partition being read
+inline int sweep_partition(Partitions& files, int k, uint64_t per_partition, int depth, const Options& opt,
+	double* prev_date, int32_t* prev_result, int32_t* transition)
+{
+	const uint64_t count { files.count(k) };
+	if (count <= per_partition || files.single_subject(k)) {
+		std::vector<Record> recs { files.read(k) };
+		sweep_records(recs, prev_date, prev_result, transition, opt.cap, opt.modulate);
+		return 1;
+	}
+	if (depth == max_depth)
+		throw std::runtime_error("a partition of " + std::to_string(count) + " rows could not be split within \"memory\"");
+	const int most { std::max(max_partitions / opt.threads, 2) };
+	const int parts { int(std::min<uint64_t>(std::max<uint64_t>((count + per_partition - 1) / per_partition, min_split), most)) };
+	Partitions split(opt.tmpdir, parts);
+	const uint64_t piece { std::max<uint64_t>(per_partition / 2, 1) };
+	scatter(split, size_t(std::max<uint64_t>(per_partition / 2 / parts, 1024)), uint32_t(depth + 1), [&](auto put) {
+		files.scan(k, piece, [&](const std::vector<Record>& recs) {
+			for (const Record& r : recs)
+				put(r);
+		});
+	});
+	int swept { 0 };
+	for (int j { 0 }; j < parts; ++j)
+		swept += sweep_partition(split, j, per_partition, depth + 1, opt, prev_date, prev_result, transition);
+	return swept;
+}
+
+// Transitions of an input file of any size written to an output file, holding at most about
+// opt.memory bytes of records: rows are partitioned by a hash of subject into temporary files small
+// enough to sort in memory, any too large being split again, then partitions are swept on up to
+// opt.threads threads, writing into the mapped output at the original rows. Only a single subject
+// with more rows than a thread's share of memory is swept in memory regardless
+inline Summary stream_transitions(const std::string& input, const std::string& output, const Options& opt)
+{
+	if (opt.cap < 0 || opt.modulate < 0)
+		throw std::invalid_argument("\"cap\" or \"modulate\" less than zero");
+	if (opt.threads < 1)
+		throw std::invalid_argument("\"threads\" less than one");
+	const ColumnarFile in(input);
+	if (in.kind() != input_columns)
+		throw std::invalid_argument("\"" + input + "\" is not an input file");
+	const uint64_t n { in.rows() };
+	if (n >= uint64_t(INT64_MAX) / 16)
+		throw std::invalid_argument("\"" + input + "\" has too many rows");
+
+	// Output mapped at its final size, a single block in input row order
+	const uint64_t m { n };
+	MappedFile out(output, sizeof(Header) + 8 + block_bytes(output_columns, m));
+	Header h { new_header(output_columns) };
+	h.nrows = n;
+	h.nblocks = 1;
+	std::memcpy(out.data(), &h, sizeof h);
+	std::memcpy(out.data() + sizeof h, &m, 8);
+	const Block cols { m, out.data() + sizeof h + 8 };
+	double* prev_date { const_cast<double*>(cols.prev_date()) };
+	int32_t* prev_result { const_cast<int32_t*>(cols.prev_result()) };
+	int32_t* transition { const_cast<int32_t*>(cols.transition()) };
+
+	Summary summary;
+	summary.rows = n;
+	const uint64_t budget { std::max<uint64_t>(opt.memory / opt.threads, sizeof(Record)) };
+	const uint64_t per_partition { std::max<uint64_t>(budget / sizeof(Record), 1) };
+	const int parts { int(std::min<uint64_t>((n + per_partition - 1) / per_partition, max_partitions)) };
+	summary.partitions = std::max(parts, 1);
+	if (summary.partitions == 1) {
+		std::vector<Record> recs;
+		recs.reserve(n);
+		int64_t row { 0 };
+		for (const Block& b : in.blocks())
+			for (uint64_t x { 0 }; x < b.rows; ++x)
+				recs.push_back(Record { row++, b.timepoint()[x], b.subject()[x], b.result()[x] });
+		sweep_records(recs, prev_date, prev_result, transition, opt.cap, opt.modulate);
+		return summary;
+	}
+
+	// Scatter rows to partitions through buffers sharing half the memory
+	Partitions files(opt.tmpdir, parts);
+	scatter(files, size_t(std::max<uint64_t>(opt.memory / 2 / sizeof(Record) / parts, 1024)), 0, [&](auto put) {
+		int64_t row { 0 };
+		for (const Block& b : in.blocks())
+			for (uint64_t x { 0 }; x < b.rows; ++x)
+				put(Record { row++, b.timepoint()[x], b.subject()[x], b.result()[x] });
+	});
+
+	// Sweep partitions, each taken in turn by the next free thread
+	std::atomic<int> next { 0 }, swept { 0 };
+	std::vector<std::exception_ptr> errors(opt.threads);
+	auto work = [&](int t) {
+		try {
+			for (int k; (k = next++) < parts; )
+				swept += sweep_partition(files, k, per_partition, 0, opt, prev_date, prev_result, transition);
+		} catch (...) {
+			errors[t] = std::current_exception();
+			next = parts;
+		}
+	};
+	std::vector<std::thread> pool;
+	for (int t { 1 }; t < std::min(opt.threads, parts); ++t)
+		pool.emplace_back(work, t);
+	work(0);
+	for (auto& th : pool)
+		th.join();
+	for (auto& e : errors)
+		if (e)
+			std::rethrow_exception(e);
+	summary.partitions = swept;
+	return summary;
+}
+
+}	// namespace transition_stream
+
+#endif  // TRANSITION_STREAM_H
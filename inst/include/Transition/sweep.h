@@ -0,0 +1,136 @@
+/// __________________________________________________
+/// Transition/sweep.h
+/// __________________________________________________
+///
+/// Rules shared by every engine, header-only and independent of R: how a difference of results is
+/// adjusted, when a transition is missing, and how rows tied on subject and timepoint form a single
+/// run, represented by its first kept row, whose result serves every row of the following run. The
+/// sweep of records held in memory, by which stream.h and csv.h find transitions, is built on them.
+///
+/// Missing values are those of R: NA_integer_ is INT32_MIN and NA_real_ the NaN with low word 1954.
+/// __________________________________________________
+
+#ifndef TRANSITION_SWEEP_H
+#define TRANSITION_SWEEP_H
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace transition_sweep {
+
+constexpr int32_t na_integer { INT32_MIN };
+
+inline double na_real()
+{
+	const uint64_t bits { 0x7FF00000000007A2ULL };
+	double na;
+	std::memcpy(&na, &bits, sizeof na);
+	return na;
+}
+
+
+/// __________________________________________________
+/// Transitions
+
+// Difference in levels, optionally modulated then capped, symmetrically about zero; the magnitude is
+// taken unsigned, so that any difference, even of NA, is defined
+inline int adjust(int diff, int cap, int modulate)
+{
+	const bool neg { diff < 0 };
+	uint32_t mag { neg ? 0u - uint32_t(diff) : uint32_t(diff) };
+	if (modulate > 1)
+		mag = (mag + uint32_t(modulate) - 1) / uint32_t(modulate);
+	if (cap)
+		mag = std::min(mag, uint32_t(cap));
+	return int32_t(neg ? 0u - mag : mag);
+}
+
+// Transition from result prev to result curr as adjusted by adj, NA if either is NA; the difference
+// is taken unsigned, and whether or not it is needed, so that loops over results need not branch
+template<class A>
+inline int32_t transition(int32_t prev, int32_t curr, A adj)
+{
+	const int32_t t { adj(int32_t(uint32_t(curr) - uint32_t(prev))) };
+	return (na_integer == prev || na_integer == curr) ? na_integer : t;
+}
+
+
+/// __________________________________________________
+/// Runs
+
+// End of the run of index positions from k, before last, tied with k on subject and timepoint as
+// told by tied(j), and the position of its kept row with the lowest row(j), or -1 if none is kept
+template<class I, class Tied, class Row, class Keep>
+inline I run_of(I k, I last, I& end, Tied tied, Row row, Keep keep)
+{
+	I rep { keep(row(k)) ? k : I(-1) };
+	for (end = k + 1; end < last && tied(end); ++end)
+		if (keep(row(end)) && (rep < 0 || row(end) < row(rep)))
+			rep = end;
+	return rep;
+}
+
+struct KeepAll { template<class R> bool operator()(R) const { return true; } };
+
+
+/// __________________________________________________
+/// Records
+
+// Test row as held in memory and in partition files
+struct Record {
+	int64_t row;
+	double date;
+	int32_t subject, result;
+};
+
+inline bool record_order(const Record& a, const Record& b)
+{
+	return a.subject != b.subject ? a.subject < b.subject : a.date != b.date ? a.date < b.date : a.row < b.row;
+}
+
+// Previous timepoints, previous results and transitions of records of whole subjects, already in
+// record_order(), written to the output columns at their rows
+inline void sweep_sorted(const std::vector<Record>& recs, double* prev_date, int32_t* prev_result, int32_t* transition_col, int cap,
+	int modulate)
+{
+	const double na { na_real() };
+	const auto adj = [cap, modulate](int diff) { return adjust(diff, cap, modulate); };
+	const int64_t n { int64_t(recs.size()) };
+	const Record* prev { nullptr };
+	for (int64_t k { 0 }, end; k < n; k = end) {
+		const Record& first { recs[k] };
+		const int64_t rep { run_of(k, n, end,
+			[&](int64_t j) { return recs[j].subject == first.subject && recs[j].date == first.date; },
+			[&](int64_t j) { return recs[j].row; }, KeepAll()) };
+		for (int64_t j { k }; j < end; ++j) {
+			const int64_t row { recs[j].row };
+			prev_date[row] = prev ? prev->date : na;
+			prev_result[row] = prev ? prev->result : na_integer;
+			transition_col[row] = prev ? transition(prev->result, recs[j].result, adj) : na_integer;
+		}
+		prev = (end < n && recs[end].subject == first.subject) ? &recs[rep] : nullptr;
+	}
+}
+
+// As sweep_sorted(), for records in any order, which are first checked for missing timepoints and
+// sorted
+inline void sweep_records(std::vector<Record>& recs, double* prev_date, int32_t* prev_result, int32_t* transition_col, int cap,
+	int modulate)
+{
+	for (const Record& r : recs)
+		if (std::isnan(r.date))
+			throw std::invalid_argument("missing timepoint in row " + std::to_string(r.row + 1));
+	std::sort(recs.begin(), recs.end(), record_order);
+	sweep_sorted(recs, prev_date, prev_result, transition_col, cap, modulate);
+}
+
+}	// namespace transition_sweep
+
+#endif  // TRANSITION_SWEEP_H
@@ -11,119 +11,501 @@ Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
 // add_transitions
-DataFrame add_transitions(DataFrame object, const char* subject, const char* timepoint, const char* result, const char* transition, int cap, int modulate);
-RcppExport SEXP _Transition_add_transitions(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP transitionSEXP, SEXP capSEXP, SEXP modulateSEXP) {
+DataFrame add_transitions(DataFrame object, CharacterVector subject, const char* timepoint, CharacterVector result, CharacterVector transition, int cap, int modulate, bool forward, const char* na, double min_gap, double max_gap, Nullable<IntegerMatrix> codes, int threads);
+RcppExport SEXP _Transition_add_transitions(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP transitionSEXP, SEXP capSEXP, SEXP modulateSEXP, SEXP forwardSEXP, SEXP naSEXP, SEXP min_gapSEXP, SEXP max_gapSEXP, SEXP codesSEXP, SEXP threadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
-    Rcpp::traits::input_parameter< const char* >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
     Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
-    Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
-    Rcpp::traits::input_parameter< const char* >::type transition(transitionSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type result(resultSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type transition(transitionSEXP);
     Rcpp::traits::input_parameter< int >::type cap(capSEXP);
     Rcpp::traits::input_parameter< int >::type modulate(modulateSEXP);
-    rcpp_result_gen = Rcpp::wrap(add_transitions(object, subject, timepoint, result, transition, cap, modulate));
+    Rcpp::traits::input_parameter< bool >::type forward(forwardSEXP);
+    Rcpp::traits::input_parameter< const char* >::type na(naSEXP);
+    Rcpp::traits::input_parameter< double >::type min_gap(min_gapSEXP);
+    Rcpp::traits::input_parameter< double >::type max_gap(max_gapSEXP);
+    Rcpp::traits::input_parameter< Nullable<IntegerMatrix> >::type codes(codesSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(add_transitions(object, subject, timepoint, result, transition, cap, modulate, forward, na, min_gap, max_gap, codes, threads));
     return rcpp_result_gen;
 END_RCPP
 }
 // get_transitions
-IntegerVector get_transitions(DataFrame object, const char* subject, const char* timepoint, const char* result, int cap, int modulate);
-RcppExport SEXP _Transition_get_transitions(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP capSEXP, SEXP modulateSEXP) {
+RObject get_transitions(DataFrame object, CharacterVector subject, const char* timepoint, CharacterVector result, int cap, int modulate, bool forward, const char* na, double min_gap, double max_gap, Nullable<IntegerMatrix> codes, int threads);
+RcppExport SEXP _Transition_get_transitions(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP capSEXP, SEXP modulateSEXP, SEXP forwardSEXP, SEXP naSEXP, SEXP min_gapSEXP, SEXP max_gapSEXP, SEXP codesSEXP, SEXP threadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
-    Rcpp::traits::input_parameter< const char* >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
     Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
-    Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type result(resultSEXP);
     Rcpp::traits::input_parameter< int >::type cap(capSEXP);
     Rcpp::traits::input_parameter< int >::type modulate(modulateSEXP);
-    rcpp_result_gen = Rcpp::wrap(get_transitions(object, subject, timepoint, result, cap, modulate));
+    Rcpp::traits::input_parameter< bool >::type forward(forwardSEXP);
+    Rcpp::traits::input_parameter< const char* >::type na(naSEXP);
+    Rcpp::traits::input_parameter< double >::type min_gap(min_gapSEXP);
+    Rcpp::traits::input_parameter< double >::type max_gap(max_gapSEXP);
+    Rcpp::traits::input_parameter< Nullable<IntegerMatrix> >::type codes(codesSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_transitions(object, subject, timepoint, result, cap, modulate, forward, na, min_gap, max_gap, codes, threads));
     return rcpp_result_gen;
 END_RCPP
 }
 // add_prev_date
-DataFrame add_prev_date(DataFrame object, const char* subject, const char* timepoint, const char* result, const char* prev_date);
-RcppExport SEXP _Transition_add_prev_date(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP prev_dateSEXP) {
+DataFrame add_prev_date(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, const char* prev_date, int threads);
+RcppExport SEXP _Transition_add_prev_date(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP prev_dateSEXP, SEXP threadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
-    Rcpp::traits::input_parameter< const char* >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
     Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
     Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
     Rcpp::traits::input_parameter< const char* >::type prev_date(prev_dateSEXP);
-    rcpp_result_gen = Rcpp::wrap(add_prev_date(object, subject, timepoint, result, prev_date));
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(add_prev_date(object, subject, timepoint, result, prev_date, threads));
     return rcpp_result_gen;
 END_RCPP
 }
 // get_prev_date
-DateVector get_prev_date(DataFrame object, const char* subject, const char* timepoint, const char* result);
-RcppExport SEXP _Transition_get_prev_date(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP) {
+RObject get_prev_date(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, IntegerVector lag, int threads);
+RcppExport SEXP _Transition_get_prev_date(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP lagSEXP, SEXP threadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
-    Rcpp::traits::input_parameter< const char* >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
     Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
     Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
-    rcpp_result_gen = Rcpp::wrap(get_prev_date(object, subject, timepoint, result));
+    Rcpp::traits::input_parameter< IntegerVector >::type lag(lagSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_prev_date(object, subject, timepoint, result, lag, threads));
     return rcpp_result_gen;
 END_RCPP
 }
 // add_prev_result
-DataFrame add_prev_result(DataFrame object, const char* subject, const char* timepoint, const char* result, const char* prev_result);
-RcppExport SEXP _Transition_add_prev_result(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP prev_resultSEXP) {
+DataFrame add_prev_result(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, const char* prev_result, int threads);
+RcppExport SEXP _Transition_add_prev_result(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP prev_resultSEXP, SEXP threadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
-    Rcpp::traits::input_parameter< const char* >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
     Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
     Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
     Rcpp::traits::input_parameter< const char* >::type prev_result(prev_resultSEXP);
-    rcpp_result_gen = Rcpp::wrap(add_prev_result(object, subject, timepoint, result, prev_result));
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(add_prev_result(object, subject, timepoint, result, prev_result, threads));
     return rcpp_result_gen;
 END_RCPP
 }
 // get_prev_result
-IntegerVector get_prev_result(DataFrame object, const char* subject, const char* timepoint, const char* result);
-RcppExport SEXP _Transition_get_prev_result(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP) {
+RObject get_prev_result(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, IntegerVector lag, int threads);
+RcppExport SEXP _Transition_get_prev_result(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP lagSEXP, SEXP threadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
-    Rcpp::traits::input_parameter< const char* >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
     Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
     Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
-    rcpp_result_gen = Rcpp::wrap(get_prev_result(object, subject, timepoint, result));
+    Rcpp::traits::input_parameter< IntegerVector >::type lag(lagSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_prev_result(object, subject, timepoint, result, lag, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_next_date
+NumericVector get_next_date(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, int threads);
+RcppExport SEXP _Transition_get_next_date(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
+    Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_next_date(object, subject, timepoint, result, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_next_result
+IntegerVector get_next_result(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, int threads);
+RcppExport SEXP _Transition_get_next_result(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
+    Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_next_result(object, subject, timepoint, result, threads));
     return rcpp_result_gen;
 END_RCPP
 }
 // uniques
-List uniques(DataFrame object, const char* subject, const char* timepoint, const char* result);
-RcppExport SEXP _Transition_uniques(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP) {
+List uniques(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, bool counts);
+RcppExport SEXP _Transition_uniques(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP countsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
+    Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
+    Rcpp::traits::input_parameter< bool >::type counts(countsSEXP);
+    rcpp_result_gen = Rcpp::wrap(uniques(object, subject, timepoint, result, counts));
+    return rcpp_result_gen;
+END_RCPP
+}
+// prepare_transitions
+SEXP prepare_transitions(DataFrame object, CharacterVector subject, const char* timepoint, const char* result);
+RcppExport SEXP _Transition_prepare_transitions(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
+    Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
+    rcpp_result_gen = Rcpp::wrap(prepare_transitions(object, subject, timepoint, result));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_transitions_prepared
+IntegerVector get_transitions_prepared(SEXP prepared, int cap, int modulate, bool forward, const char* na, double min_gap, double max_gap, Nullable<IntegerMatrix> codes, int threads);
+RcppExport SEXP _Transition_get_transitions_prepared(SEXP preparedSEXP, SEXP capSEXP, SEXP modulateSEXP, SEXP forwardSEXP, SEXP naSEXP, SEXP min_gapSEXP, SEXP max_gapSEXP, SEXP codesSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type prepared(preparedSEXP);
+    Rcpp::traits::input_parameter< int >::type cap(capSEXP);
+    Rcpp::traits::input_parameter< int >::type modulate(modulateSEXP);
+    Rcpp::traits::input_parameter< bool >::type forward(forwardSEXP);
+    Rcpp::traits::input_parameter< const char* >::type na(naSEXP);
+    Rcpp::traits::input_parameter< double >::type min_gap(min_gapSEXP);
+    Rcpp::traits::input_parameter< double >::type max_gap(max_gapSEXP);
+    Rcpp::traits::input_parameter< Nullable<IntegerMatrix> >::type codes(codesSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_transitions_prepared(prepared, cap, modulate, forward, na, min_gap, max_gap, codes, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_prev_date_prepared
+RObject get_prev_date_prepared(SEXP prepared, IntegerVector lag, int threads);
+RcppExport SEXP _Transition_get_prev_date_prepared(SEXP preparedSEXP, SEXP lagSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type prepared(preparedSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type lag(lagSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_prev_date_prepared(prepared, lag, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_prev_result_prepared
+RObject get_prev_result_prepared(SEXP prepared, IntegerVector lag, int threads);
+RcppExport SEXP _Transition_get_prev_result_prepared(SEXP preparedSEXP, SEXP lagSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type prepared(preparedSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type lag(lagSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_prev_result_prepared(prepared, lag, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_next_date_prepared
+NumericVector get_next_date_prepared(SEXP prepared, int threads);
+RcppExport SEXP _Transition_get_next_date_prepared(SEXP preparedSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type prepared(preparedSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_next_date_prepared(prepared, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// get_next_result_prepared
+IntegerVector get_next_result_prepared(SEXP prepared, int threads);
+RcppExport SEXP _Transition_get_next_result_prepared(SEXP preparedSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type prepared(preparedSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(get_next_result_prepared(prepared, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// uniques_prepared
+List uniques_prepared(SEXP prepared, bool counts);
+RcppExport SEXP _Transition_uniques_prepared(SEXP preparedSEXP, SEXP countsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type prepared(preparedSEXP);
+    Rcpp::traits::input_parameter< bool >::type counts(countsSEXP);
+    rcpp_result_gen = Rcpp::wrap(uniques_prepared(prepared, counts));
+    return rcpp_result_gen;
+END_RCPP
+}
+// add_transition_columns
+DataFrame add_transition_columns(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, const char* prev_date, const char* prev_result, const char* transition, const char* interval, const char* next_date, const char* next_result, const char* days, int cap, int modulate, bool forward, const char* na, double min_gap, double max_gap, int threads);
+RcppExport SEXP _Transition_add_transition_columns(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP prev_dateSEXP, SEXP prev_resultSEXP, SEXP transitionSEXP, SEXP intervalSEXP, SEXP next_dateSEXP, SEXP next_resultSEXP, SEXP daysSEXP, SEXP capSEXP, SEXP modulateSEXP, SEXP forwardSEXP, SEXP naSEXP, SEXP min_gapSEXP, SEXP max_gapSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
+    Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
+    Rcpp::traits::input_parameter< const char* >::type prev_date(prev_dateSEXP);
+    Rcpp::traits::input_parameter< const char* >::type prev_result(prev_resultSEXP);
+    Rcpp::traits::input_parameter< const char* >::type transition(transitionSEXP);
+    Rcpp::traits::input_parameter< const char* >::type interval(intervalSEXP);
+    Rcpp::traits::input_parameter< const char* >::type next_date(next_dateSEXP);
+    Rcpp::traits::input_parameter< const char* >::type next_result(next_resultSEXP);
+    Rcpp::traits::input_parameter< const char* >::type days(daysSEXP);
+    Rcpp::traits::input_parameter< int >::type cap(capSEXP);
+    Rcpp::traits::input_parameter< int >::type modulate(modulateSEXP);
+    Rcpp::traits::input_parameter< bool >::type forward(forwardSEXP);
+    Rcpp::traits::input_parameter< const char* >::type na(naSEXP);
+    Rcpp::traits::input_parameter< double >::type min_gap(min_gapSEXP);
+    Rcpp::traits::input_parameter< double >::type max_gap(max_gapSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(add_transition_columns(object, subject, timepoint, result, prev_date, prev_result, transition, interval, next_date, next_result, days, cap, modulate, forward, na, min_gap, max_gap, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// transition_state
+DataFrame transition_state(SEXP prepared);
+RcppExport SEXP _Transition_transition_state(SEXP preparedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type prepared(preparedSEXP);
+    rcpp_result_gen = Rcpp::wrap(transition_state(prepared));
+    return rcpp_result_gen;
+END_RCPP
+}
+// update_transitions
+List update_transitions(DataFrame state, DataFrame object, const char* subject, const char* timepoint, const char* result, const char* prev_date, const char* prev_result, const char* transition, int cap, int modulate, SEXP history);
+RcppExport SEXP _Transition_update_transitions(SEXP stateSEXP, SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP prev_dateSEXP, SEXP prev_resultSEXP, SEXP transitionSEXP, SEXP capSEXP, SEXP modulateSEXP, SEXP historySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type state(stateSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
+    Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
+    Rcpp::traits::input_parameter< const char* >::type prev_date(prev_dateSEXP);
+    Rcpp::traits::input_parameter< const char* >::type prev_result(prev_resultSEXP);
+    Rcpp::traits::input_parameter< const char* >::type transition(transitionSEXP);
+    Rcpp::traits::input_parameter< int >::type cap(capSEXP);
+    Rcpp::traits::input_parameter< int >::type modulate(modulateSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type history(historySEXP);
+    rcpp_result_gen = Rcpp::wrap(update_transitions(state, object, subject, timepoint, result, prev_date, prev_result, transition, cap, modulate, history));
+    return rcpp_result_gen;
+END_RCPP
+}
+// transition_matrix
+IntegerVector transition_matrix(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, const char* by, int threads);
+RcppExport SEXP _Transition_transition_matrix(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP bySEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
+    Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
+    Rcpp::traits::input_parameter< const char* >::type by(bySEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(transition_matrix(object, subject, timepoint, result, by, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// subject_summary
+DataFrame subject_summary(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, const char* positive, int threads);
+RcppExport SEXP _Transition_subject_summary(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP positiveSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
+    Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
+    Rcpp::traits::input_parameter< const char* >::type positive(positiveSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(subject_summary(object, subject, timepoint, result, positive, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// transition_episodes
+DataFrame transition_episodes(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, int threads);
+RcppExport SEXP _Transition_transition_episodes(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
+    Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(transition_episodes(object, subject, timepoint, result, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// synthetic_study
+DataFrame synthetic_study(int subjects, int visits, int levels, const char* order, bool unbalanced);
+RcppExport SEXP _Transition_synthetic_study(SEXP subjectsSEXP, SEXP visitsSEXP, SEXP levelsSEXP, SEXP orderSEXP, SEXP unbalancedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type subjects(subjectsSEXP);
+    Rcpp::traits::input_parameter< int >::type visits(visitsSEXP);
+    Rcpp::traits::input_parameter< int >::type levels(levelsSEXP);
+    Rcpp::traits::input_parameter< const char* >::type order(orderSEXP);
+    Rcpp::traits::input_parameter< bool >::type unbalanced(unbalancedSEXP);
+    rcpp_result_gen = Rcpp::wrap(synthetic_study(subjects, visits, levels, order, unbalanced));
+    return rcpp_result_gen;
+END_RCPP
+}
+// reference_transitions
+DataFrame reference_transitions(DataFrame object, const char* subject, const char* timepoint, const char* result, int cap, int modulate, int lag);
+RcppExport SEXP _Transition_reference_transitions(SEXP objectSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP capSEXP, SEXP modulateSEXP, SEXP lagSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
+    Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
+    Rcpp::traits::input_parameter< int >::type cap(capSEXP);
+    Rcpp::traits::input_parameter< int >::type modulate(modulateSEXP);
+    Rcpp::traits::input_parameter< int >::type lag(lagSEXP);
+    rcpp_result_gen = Rcpp::wrap(reference_transitions(object, subject, timepoint, result, cap, modulate, lag));
+    return rcpp_result_gen;
+END_RCPP
+}
+// transition_profile
+DataFrame transition_profile(bool reset);
+RcppExport SEXP _Transition_transition_profile(SEXP resetSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< bool >::type reset(resetSEXP);
+    rcpp_result_gen = Rcpp::wrap(transition_profile(reset));
+    return rcpp_result_gen;
+END_RCPP
+}
+// write_transition_file
+double write_transition_file(DataFrame object, const char* path, CharacterVector subject, const char* timepoint, const char* result, bool append);
+RcppExport SEXP _Transition_write_transition_file(SEXP objectSEXP, SEXP pathSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP appendSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type object(objectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type subject(subjectSEXP);
+    Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
+    Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
+    Rcpp::traits::input_parameter< bool >::type append(appendSEXP);
+    rcpp_result_gen = Rcpp::wrap(write_transition_file(object, path, subject, timepoint, result, append));
+    return rcpp_result_gen;
+END_RCPP
+}
+// stream_transitions
+List stream_transitions(const char* input, const char* output, int cap, int modulate, double memory, const char* tmpdir, int threads);
+RcppExport SEXP _Transition_stream_transitions(SEXP inputSEXP, SEXP outputSEXP, SEXP capSEXP, SEXP modulateSEXP, SEXP memorySEXP, SEXP tmpdirSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const char* >::type input(inputSEXP);
+    Rcpp::traits::input_parameter< const char* >::type output(outputSEXP);
+    Rcpp::traits::input_parameter< int >::type cap(capSEXP);
+    Rcpp::traits::input_parameter< int >::type modulate(modulateSEXP);
+    Rcpp::traits::input_parameter< double >::type memory(memorySEXP);
+    Rcpp::traits::input_parameter< const char* >::type tmpdir(tmpdirSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(stream_transitions(input, output, cap, modulate, memory, tmpdir, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// read_transition_file
+DataFrame read_transition_file(const char* path, double first, double rows);
+RcppExport SEXP _Transition_read_transition_file(SEXP pathSEXP, SEXP firstSEXP, SEXP rowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const char* >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< double >::type first(firstSEXP);
+    Rcpp::traits::input_parameter< double >::type rows(rowsSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_transition_file(path, first, rows));
+    return rcpp_result_gen;
+END_RCPP
+}
+// read_transitions_csv
+DataFrame read_transitions_csv(const char* path, const char* subject, const char* timepoint, const char* result, Nullable<CharacterVector> levels, const char* delimiter, int cap, int modulate, double chunk, int threads);
+RcppExport SEXP _Transition_read_transitions_csv(SEXP pathSEXP, SEXP subjectSEXP, SEXP timepointSEXP, SEXP resultSEXP, SEXP levelsSEXP, SEXP delimiterSEXP, SEXP capSEXP, SEXP modulateSEXP, SEXP chunkSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const char* >::type path(pathSEXP);
     Rcpp::traits::input_parameter< const char* >::type subject(subjectSEXP);
     Rcpp::traits::input_parameter< const char* >::type timepoint(timepointSEXP);
     Rcpp::traits::input_parameter< const char* >::type result(resultSEXP);
-    rcpp_result_gen = Rcpp::wrap(uniques(object, subject, timepoint, result));
+    Rcpp::traits::input_parameter< Nullable<CharacterVector> >::type levels(levelsSEXP);
+    Rcpp::traits::input_parameter< const char* >::type delimiter(delimiterSEXP);
+    Rcpp::traits::input_parameter< int >::type cap(capSEXP);
+    Rcpp::traits::input_parameter< int >::type modulate(modulateSEXP);
+    Rcpp::traits::input_parameter< double >::type chunk(chunkSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_transitions_csv(path, subject, timepoint, result, levels, delimiter, cap, modulate, chunk, threads));
     return rcpp_result_gen;
 END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_Transition_add_transitions", (DL_FUNC) &_Transition_add_transitions, 7},
-    {"_Transition_get_transitions", (DL_FUNC) &_Transition_get_transitions, 6},
-    {"_Transition_add_prev_date", (DL_FUNC) &_Transition_add_prev_date, 5},
-    {"_Transition_get_prev_date", (DL_FUNC) &_Transition_get_prev_date, 4},
-    {"_Transition_add_prev_result", (DL_FUNC) &_Transition_add_prev_result, 5},
-    {"_Transition_get_prev_result", (DL_FUNC) &_Transition_get_prev_result, 4},
-    {"_Transition_uniques", (DL_FUNC) &_Transition_uniques, 4},
+    {"_Transition_add_transitions", (DL_FUNC) &_Transition_add_transitions, 13},
+    {"_Transition_get_transitions", (DL_FUNC) &_Transition_get_transitions, 12},
+    {"_Transition_add_prev_date", (DL_FUNC) &_Transition_add_prev_date, 6},
+    {"_Transition_get_prev_date", (DL_FUNC) &_Transition_get_prev_date, 6},
+    {"_Transition_add_prev_result", (DL_FUNC) &_Transition_add_prev_result, 6},
+    {"_Transition_get_prev_result", (DL_FUNC) &_Transition_get_prev_result, 6},
+    {"_Transition_get_next_date", (DL_FUNC) &_Transition_get_next_date, 5},
+    {"_Transition_get_next_result", (DL_FUNC) &_Transition_get_next_result, 5},
+    {"_Transition_uniques", (DL_FUNC) &_Transition_uniques, 5},
+    {"_Transition_prepare_transitions", (DL_FUNC) &_Transition_prepare_transitions, 4},
+    {"_Transition_get_transitions_prepared", (DL_FUNC) &_Transition_get_transitions_prepared, 9},
+    {"_Transition_get_prev_date_prepared", (DL_FUNC) &_Transition_get_prev_date_prepared, 3},
+    {"_Transition_get_prev_result_prepared", (DL_FUNC) &_Transition_get_prev_result_prepared, 3},
+    {"_Transition_get_next_date_prepared", (DL_FUNC) &_Transition_get_next_date_prepared, 2},
+    {"_Transition_get_next_result_prepared", (DL_FUNC) &_Transition_get_next_result_prepared, 2},
+    {"_Transition_uniques_prepared", (DL_FUNC) &_Transition_uniques_prepared, 2},
+    {"_Transition_add_transition_columns", (DL_FUNC) &_Transition_add_transition_columns, 18},
+    {"_Transition_transition_state", (DL_FUNC) &_Transition_transition_state, 1},
+    {"_Transition_update_transitions", (DL_FUNC) &_Transition_update_transitions, 11},
+    {"_Transition_transition_matrix", (DL_FUNC) &_Transition_transition_matrix, 6},
+    {"_Transition_subject_summary", (DL_FUNC) &_Transition_subject_summary, 6},
+    {"_Transition_transition_episodes", (DL_FUNC) &_Transition_transition_episodes, 5},
+    {"_Transition_synthetic_study", (DL_FUNC) &_Transition_synthetic_study, 5},
+    {"_Transition_reference_transitions", (DL_FUNC) &_Transition_reference_transitions, 7},
+    {"_Transition_transition_profile", (DL_FUNC) &_Transition_transition_profile, 1},
+    {"_Transition_write_transition_file", (DL_FUNC) &_Transition_write_transition_file, 6},
+    {"_Transition_stream_transitions", (DL_FUNC) &_Transition_stream_transitions, 7},
+    {"_Transition_read_transition_file", (DL_FUNC) &_Transition_read_transition_file, 3},
+    {"_Transition_read_transitions_csv", (DL_FUNC) &_Transition_read_transitions_csv, 10},
     {NULL, NULL, 0}
 };
 
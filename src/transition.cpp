@@ -1,8 +1,18 @@
 
 // [[Rcpp::plugins(cpp23)]]
 
+#include <Transition/sweep.h>
+#include <Transition/stream.h>		// before R headers, which clash with those of Windows
+#include <Transition/csv.h>
 #include <Rcpp.h>
 #include <cxxabi.h>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <exception>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
 using namespace Rcpp;
 
 #include "transition.h"
@@ -19,14 +29,6 @@ using std::vector;
 /// Development and Debugging functions
 #ifdef DEBUG
 
-/// Report object construction and destruction
-void _ctrsgn(const std::type_info& obj, bool destruct)
-{
-	cout << (destruct ? "Destroying " : "Constructing ") << std::flush;
-	string s { obj.name() };
-	system(("c++filt -t " + s).data());
-}
-
 /// Demangle object names functor
 class Demangler {
 	char* p;
@@ -43,8 +45,68 @@ ostream& operator<< (ostream& stream, const Demangler& d)
   return stream << string(d);
 }
 
+/// Report object construction and destruction
+void _ctrsgn(const std::type_info& obj, bool destruct)
+{
+	cout << (destruct ? "Destroying " : "Constructing ") << Demangler(obj) << endl;
+}
+
 #endif // #ifdef DEBUG
 
+/// __________________________________________________
+/// Profiling
+
+// Wall time and bytes allocated by phase, accumulated since last reported by transition_profile()
+struct PhaseRecord { string name; int calls; double seconds; double bytes; };
+
+vector<PhaseRecord>& phase_records()
+{
+//	cout << "@phase_records()\n";
+	static vector<PhaseRecord> records;
+	return records;
+}
+
+// Whether option "Transition.profile" is TRUE; read on the main thread only
+bool profiling()
+{
+//	cout << "@profiling()\n";
+	SEXP opt { Rf_GetOption1(Rf_install("Transition.profile")) };
+	return !Rf_isNull(opt) && Rf_asLogical(opt) == TRUE;
+}
+
+Phase::Phase(const char* name, double bytes) : name(name), bytes(bytes), on(profiling())
+{
+//	cout << "§Phase::Phase(const char*, double) name " << name << "; on " << on << endl;
+	if (on)
+		start = std::chrono::steady_clock::now();
+}
+
+Phase::~Phase()
+{
+//	cout << "§Phase::~Phase() name " << name << endl;
+	if (!on)
+		return;
+	const double seconds { std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+	auto& records { phase_records() };
+	auto it { std::find_if(records.begin(), records.end(), [this](const PhaseRecord& r) { return r.name == name; }) };
+	if (it == records.end())
+		records.push_back({ name, 1, seconds, bytes });
+	else {
+		++it->calls;
+		it->seconds += seconds;
+		it->bytes += bytes;
+	}
+}
+
+// New R vector of length n, its allocation recorded in phase "wrap"
+template<class V>
+inline V new_vector(R_xlen_t n)
+{
+//	cout << "@new_vector<V>(R_xlen_t) n " << n << endl;
+	Phase phase("wrap", double(n) * sizeof(typename std::remove_reference<decltype(*std::declval<V>().begin())>::type));
+	return V(n);
+}
+
 /// __________________________________________________
 /// Utility
 
@@ -78,343 +140,3546 @@ int colpos(const DataFrame object, const char* colname)
 	return object.offset(colname);
 }
 
+// Find data frame columns with specified names
+vector<int> colpos(const DataFrame object, const CharacterVector& colnames)
+{
+//	cout << "@colpos(const DataFrame, const CharacterVector&) " << colnames.size() << " names\n";
+	if (!colnames.size())
+		stop("No column names specified");
+	vector<int> cols;
+	for (R_xlen_t x { 0 }; x < colnames.size(); ++x)
+		cols.push_back(colpos(object, CHAR(STRING_ELT(colnames, x))));
+	return cols;
+}
+
+
+/// __________________________________________________
+/// Whether missing results are to be skipped, rather than propagated to the transitions that use them
+bool skip_na(const char* na)
+{
+//	cout << "@skip_na(const char*) na " << na << endl;
+	const string how { str_tolower(na) };
+	if (how != "propagate" && how != "skip")
+		throw std::invalid_argument("\"na\" not one of \"propagate\" or \"skip\"");
+	return how == "skip";
+}
+
+// Matrix of transition codes, or an empty matrix for transitions found by cap and modulate
+inline IntegerMatrix code_matrix(const Nullable<IntegerMatrix>& codes)
+{
+//	cout << "@code_matrix(const Nullable<IntegerMatrix>&)\n";
+	return codes.isNull() ? IntegerMatrix() : IntegerMatrix(codes.get());
+}
+
+// Window of time from a previous timepoint, or to a next one, within which it is used
+Window gap_window(double min_gap, double max_gap)
+{
+//	cout << "@gap_window(double, double) min_gap " << min_gap << "; max_gap " << max_gap << endl;
+	if (ISNAN(min_gap) || ISNAN(max_gap))
+		throw std::invalid_argument("\"min_gap\" or \"max_gap\" missing");
+	if (min_gap < 0)
+		throw std::invalid_argument("\"min_gap\" less than zero");
+	if (max_gap < min_gap)
+		throw std::invalid_argument("\"max_gap\" less than \"min_gap\"");
+	return Window { min_gap, max_gap };
+}
+
+
+/// __________________________________________________
+/// Calendar year and month of a day number from 1970-01-01 (see H. Hinnant, "chrono-Compatible
+/// Low-Level Date Algorithms", civil_from_days)
+inline std::pair<int, int> year_month(int64_t days)
+{
+	days += 719468;
+	const int64_t era { (days >= 0 ? days : days - 146096) / 146097 };
+	const unsigned doe = days - era * 146097;
+	const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	const unsigned mp = (5 * doy + 2) / 153;
+	const int month = (mp < 10) ? mp + 3 : mp - 9;
+	return { int(yoe + era * 400 + (month <= 2)), month };
+}
+
+// Calendar months, as year * 12 + month - 1, of POSIXct times in their own time zone, or the
+// session's if they have none, converted by R's as.POSIXlt() on the calling thread
+vector<int> local_months(const NumericVector& times)
+{
+//	cout << "@local_months(const NumericVector&)\n";
+	const RObject tzone { times.attr("tzone") };
+	const string tz { Rf_isNull(tzone) ? "" : string(CharacterVector(tzone)[0]) };
+	const List lt { Function("as.POSIXlt")(times, _["tz"] = tz) };
+	const IntegerVector year { lt["year"] }, mon { lt["mon"] };
+	vector<int> months(times.size());
+	for (R_xlen_t x { 0 }; x < times.size(); ++x)
+		months[x] = (NA_INTEGER == year[x] || NA_INTEGER == mon[x]) ? NA_INTEGER : (1900 + year[x]) * 12 + mon[x];
+	return months;
+}
+
+
+/// __________________________________________________
+/// Give vector of results the ordered factor class and levels of result column
+inline void result_attrs(IntegerVector& intvec, const IntegerVector& colobj)
+{
+//	cout << "@result_attrs(IntegerVector&, const IntegerVector&)\n";
+	if (colobj.inherits("factor") && colobj.inherits("ordered"))
+		intvec.attr("class") = CharacterVector::create("factor", "ordered");
+	intvec.attr("levels") = colobj.attr("levels");
+}
+
+
+/// __________________________________________________
+/// Give vector of timepoints the class and time zone of timepoint column, e.g. Date or POSIXct
+inline void date_attrs(NumericVector& datevec, const NumericVector& colobj)
+{
+//	cout << "@date_attrs(NumericVector&, const NumericVector&)\n";
+	datevec.attr("class") = colobj.attr("class");
+	datevec.attr("tzone") = colobj.attr("tzone");
+}
+
 
-// Find unique values in vector
+/// __________________________________________________
+/// Dictionary-encode strings as codes from 1 in C-locale order of the unique strings, which are
+/// returned in labels; strings are identified by their CHARSXP in R's global cache, so hashing
+/// pointers suffices
+IntegerVector encode_strings(SEXP strings, CharacterVector& labels)
+{
+//	cout << "@encode_strings(SEXP, CharacterVector&) length " << Rf_xlength(strings) << endl;
+	const R_xlen_t n { Rf_xlength(strings) };
+	IntegerVector codes { new_vector<IntegerVector>(n) };
+	std::unordered_map<SEXP, int> seen;
+	vector<SEXP> uniq;
+	for (R_xlen_t x { 0 }; x < n; ++x) {
+		const SEXP str { STRING_ELT(strings, x) };
+		if (NA_STRING == str) {
+			codes[x] = NA_INTEGER;
+			continue;
+		}
+		const auto found { seen.try_emplace(str, int(uniq.size())) };
+		if (found.second)
+			uniq.push_back(str);
+		codes[x] = found.first->second;
+	}
+	vector<int> rank(uniq.size());
+	std::iota(rank.begin(), rank.end(), 0);
+	std::sort(rank.begin(), rank.end(), [&uniq](int a, int b) { return strcmp(CHAR(uniq[a]), CHAR(uniq[b])) < 0; });
+	vector<int> code_of(uniq.size());
+	labels = CharacterVector(uniq.size());
+	for (size_t r { 0 }; r < rank.size(); ++r) {
+		code_of[rank[r]] = r + 1;
+		SET_STRING_ELT(labels, r, uniq[rank[r]]);
+	}
+	for (R_xlen_t x { 0 }; x < n; ++x)
+		if (NA_INTEGER != codes[x])
+			codes[x] = code_of[codes[x]];
+	return codes;
+}
+
+
+/// __________________________________________________
+/// Names of transition columns for these result columns: as given, one per result column, or a
+/// single name suffixed with the name of each result column
+vector<string> transition_names(const CharacterVector& results, const CharacterVector& names)
+{
+//	cout << "@transition_names(const CharacterVector&, const CharacterVector&)\n";
+	vector<string> out;
+	if (names.size() == results.size())
+		for (R_xlen_t k { 0 }; k < names.size(); ++k)
+			out.push_back(string(names[k]));
+	else if (1 == names.size())
+		for (R_xlen_t k { 0 }; k < results.size(); ++k)
+			out.push_back(string(names[0]) + "_" + string(results[k]));
+	else
+		throw std::invalid_argument("\"transition\" not of length one or that of \"result\"");
+	return out;
+}
+
+
+/// __________________________________________________
+/// Elements of a character or integer (or factor) vector at 1-based positions, or NA
+inline RObject select_codes(SEXP values, const vector<int>& codes)
+{
+//	cout << "@select_codes(SEXP, const vector<int>&) " << codes.size() << " codes\n";
+	if (STRSXP == TYPEOF(values)) {
+		CharacterVector out(codes.size());
+		for (size_t x { 0 }; x < codes.size(); ++x)
+			SET_STRING_ELT(out, x, (NA_INTEGER == codes[x]) ? NA_STRING : STRING_ELT(values, codes[x] - 1));
+		return out;
+	}
+	const IntegerVector from(values);
+	IntegerVector out(codes.size());
+	for (size_t x { 0 }; x < codes.size(); ++x)
+		out[x] = (NA_INTEGER == codes[x]) ? NA_INTEGER : from[codes[x] - 1];
+	out.attr("class") = from.attr("class");
+	out.attr("levels") = from.attr("levels");
+	return out;
+}
+
+
+/// __________________________________________________
+/// Check two factors have identical levels (or neither has any)
+inline void same_levels(const RObject& obj, const RObject& ref, const char* what)
+{
+//	cout << "@same_levels(const RObject&, const RObject&, const char*) what " << what << endl;
+	if (!R_compute_identical(obj.attr("levels"), ref.attr("levels"), 16))
+		stop("%s levels differ from those of the state", what);
+}
+
+
+/// __________________________________________________
+/// Data frame with named list of new columns appended, allocating the list of columns only once
+DataFrame append_columns(const DataFrame& df, const List& cols)
+{
+//	cout << "@append_columns(const DataFrame&, const List&) cols " << cols.size() << endl;
+	Phase phase("wrap");
+	vector<string> names(as<vector<string>>(df.names()));
+	const int ncols = names.size();
+	for (const string& colname : as<vector<string>>(cols.names())) {
+		if (std::find(names.begin(), names.end(), colname) != names.end())
+			stop("Data frame already has column named \"%s\", try another name", colname);
+		names.push_back(colname);
+	}
+	List out(names.size());
+	for (int x { 0 }; x < ncols; ++x)
+		out[x] = df[x];
+	for (int x { 0 }; x < cols.size(); ++x)
+		out[ncols + x] = cols[x];
+	out.attr("names") = wrap(names);
+	out.attr("row.names") = df.attr("row.names");
+	out.attr("class") = df.attr("class");
+	return out;
+}
+
+
+// Find unique values in [begin, end), e.g. read directly from an R vector, with a single copy
 template<class T>
-vector<T> get_unique(const vector<T> vec)
+vector<T> get_unique(const T* begin, const T* end)
 {
-//	cout << "@get_unique<T>(const vector<T>) vec " << Demangler(typeid(vec)) << endl;
-	vector<T> out { vec };
+//	cout << "@get_unique<T>(const T*, const T*) " << Demangler(typeid(T)) << "; size " << end - begin << endl;
+	vector<T> out(begin, end);
 	std::sort(out.begin(), out.end());
 	auto last { std::unique(out.begin(), out.end()) };
 	out.erase(last, out.end());
 	return out;
 }
 
-// Adjust the difference,symmetrically
-inline int adjust(int diff, int cap, int modulate)
+// Runs of equal values in sorted vector, as unique values and their counts
+template<class T>
+void sorted_runs(const vector<T>& sorted, vector<T>& values, vector<int>& counts)
 {
-//	cout << "@adjust(int) diff " << diff << endl;
-	bool neg = std::signbit(diff);
-	diff = abs(diff);
-	if (modulate > 1)
-		diff = (diff + modulate - 1) / modulate;
-	if (bool(cap))
-		diff = (diff < cap) ? diff : cap;
-	return neg ? diff *= -1 : diff;
+//	cout << "@sorted_runs<T>(const vector<T>&, vector<T>&, vector<int>&) size " << sorted.size() << endl;
+	values.clear();
+	counts.clear();
+	for (size_t k { 0 }, end; k < sorted.size(); k = end) {
+		for (end = k + 1; end < sorted.size() && sorted[end] == sorted[k]; ++end)
+			;
+		values.push_back(sorted[k]);
+		counts.push_back(int(end - k));
+	}
 }
 
+// Unique integer codes in [begin, end) with their counts, NA first; tallied in a single pass if
+// the codes are bounded by [lo, hi] e.g., factor levels, or span no more than the number of values,
+// otherwise sorted
+inline void unique_codes(const int* begin, const int* end, int lo, int hi, vector<int>& values, vector<int>& counts)
+{
+//	cout << "@unique_codes(const int*, const int*, int, int, vector<int>&, vector<int>&) lo " << lo << "; hi " << hi << endl;
+	if (lo > hi) {
+		lo = INT_MAX;
+		hi = INT_MIN;
+		for (const int* p { begin }; p < end; ++p)
+			if (NA_INTEGER != *p) {
+				lo = std::min(lo, *p);
+				hi = std::max(hi, *p);
+			}
+	}
+	const int64_t span { int64_t(hi) - lo + 1 };
+	if (span > (end - begin) + 65536) {
+		vector<int> sorted(begin, end);
+		std::sort(sorted.begin(), sorted.end());
+		return sorted_runs(sorted, values, counts);
+	}
+	vector<int> tally(std::max<int64_t>(span, 0), 0);
+	int na { 0 };
+	for (const int* p { begin }; p < end; ++p) {
+		if (NA_INTEGER == *p)
+			++na;
+		else if (*p < lo || *p > hi)
+			throw std::invalid_argument("factor codes outside levels");
+		else
+			++tally[*p - lo];
+	}
+	values.clear();
+	counts.clear();
+	if (na) {
+		values.push_back(NA_INTEGER);
+		counts.push_back(na);
+	}
+	for (size_t k { 0 }; k < tally.size(); ++k)
+		if (tally[k]) {
+			values.push_back(lo + int(k));
+			counts.push_back(tally[k]);
+		}
+}
 
-/// __________________________________________________
-/// Class Transitiondata
+// Unique dates in [begin, end) with their counts; tallied in a single pass if all whole days
+// spanning no more than the number of dates, otherwise by LSD radix sort of order-preserving keys
+inline void unique_days(const double* begin, const double* end, vector<double>& values, vector<int>& counts)
+{
+//	cout << "@unique_days(const double*, const double*, vector<double>&, vector<int>&) size " << end - begin << endl;
+	const size_t n = end - begin;
+	values.clear();
+	counts.clear();
+	if (!n)
+		return;
+	const auto minmax { std::minmax_element(begin, end) };
+	const double lo { *minmax.first }, span { *minmax.second - lo + 1 };
+	if (span <= double(n) + 65536 && std::all_of(begin, end, [](double d) { return std::floor(d) == d; })) {
+		vector<int> tally(size_t(span), 0);
+		for (const double* p { begin }; p < end; ++p)
+			++tally[size_t(*p - lo)];
+		for (size_t k { 0 }; k < tally.size(); ++k)
+			if (tally[k]) {
+				values.push_back(lo + double(k));
+				counts.push_back(tally[k]);
+			}
+		return;
+	}
+	auto key = [](double d) {
+		uint64_t bits;
+		std::memcpy(&bits, &d, sizeof bits);
+		return (bits >> 63) ? ~bits : bits | (uint64_t(1) << 63);
+	};
+	vector<uint64_t> keys(n), swap(n);
+	std::transform(begin, end, keys.begin(), key);
+	for (int shift { 0 }; shift < 64; shift += 8) {
+		size_t bucket[257] {};
+		for (uint64_t k : keys)
+			++bucket[((k >> shift) & 0xff) + 1];
+		if (bucket[((keys[0] >> shift) & 0xff) + 1] == n)
+			continue;
+		for (int b { 0 }; b < 256; ++b)
+			bucket[b + 1] += bucket[b];
+		for (uint64_t k : keys)
+			swap[bucket[(k >> shift) & 0xff]++] = k;
+		keys.swap(swap);
+	}
+	for (size_t k { 0 }, end; k < n; k = end) {
+		for (end = k + 1; end < n && keys[end] == keys[k]; ++end)
+			;
+		const uint64_t bits { (keys[k] >> 63) ? keys[k] & ~(uint64_t(1) << 63) : ~keys[k] };
+		double d;
+		std::memcpy(&d, &bits, sizeof d);
+		values.push_back(d);
+		counts.push_back(int(end - k));
+	}
+}
 
-// Ctor auxilliary function
-template<typename T>
-T Transitiondata::typechecker(int colno, int arg)
-{	
-//	cout << "@Transitiondata::typechecker<T>(int, int) colno " << colno << "; arg " << arg << endl;
-	std::string errstr("column `");
-	errstr += vector<string>(df.names())[colno] + "`";
-	std::string wrnstr(errstr);
-	RObject colobj { df[colno] };
-	bool good = is<T>(df[colno]);
-	bool warn = false;
-	switch (arg) {
-		case 0:
-			if (!good) errstr += " not of class data.frame";
-			break;
+// Data frame of values, or of the columns of a data frame of values, with their counts
+inline DataFrame value_counts(const RObject& values, const vector<int>& counts, const string& name)
+{
+//	cout << "@value_counts(const RObject&, const vector<int>&, const string&) name " << name << endl;
+	List out;
+	if (values.inherits("data.frame")) {
+		const List cols(values);
+		const CharacterVector colnames { cols.names() };
+		for (R_xlen_t k { 0 }; k < cols.size(); ++k)
+			out.push_back(cols[k], string(colnames[k]));
+	} else
+		out.push_back(values, name);
+	out.push_back(wrap(counts), "n");
+	out.attr("row.names") = IntegerVector::create(NA_INTEGER, -int(counts.size()));
+	out.attr("class") = "data.frame";
+	return out;
+}
 
-		case 1:
-			if (!good) errstr += " not an integer or factor";
-			break;
+// Where GCC can select between them at load time, kernels are compiled for AVX2 as well as the
+// baseline instruction set, inlined whole into each, with the cost model of -O3 so that they
+// vectorise at -O2
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define TRANSITION_KERNEL __attribute__((target_clones("avx2", "default"), optimize("vect-cost-model=dynamic")))
+#define TRANSITION_INLINE __attribute__((always_inline))
+#else
+#define TRANSITION_KERNEL
+#define TRANSITION_INLINE
+#endif
 
-		case 2:
-			if (!good) {
-				if (colobj.inherits("Date")) {
-					if (!is<NumericVector>(colobj)) {
-						if (is<IntegerVector>(colobj)) {
-							wrnstr += ": Date converted from integer to numeric";
-							warn = true;
-							df[colno] = as<NumericVector>(df[colno]);
-							good = true; 
-						}
-						errstr += " not of class Date, type numeric";
-					}
-				} else errstr += " not of class Date";
-			}
-			break;
+// Unsigned division by an invariant divisor as multiplication by a precomputed inverse and shifts
+// (T. Granlund and P. L. Montgomery, "Division by Invariant Integers using Multiplication", 1994,
+// fig. 4.1), exact for all 32-bit dividends
+struct Divisor {
+	uint32_t inverse { 1 };
+	int shift1 { 0 }, shift2 { 0 };
+	Divisor() = default;
+	explicit Divisor(uint32_t d)
+	{
+		int log2d { 0 };
+		while ((uint64_t(1) << log2d) < d)
+			++log2d;
+		inverse = uint32_t((uint64_t(1) << 32) * ((uint64_t(1) << log2d) - d) / d + 1);
+		shift1 = std::min(log2d, 1);
+		shift2 = std::max(log2d - 1, 0);
+	}
+	TRANSITION_INLINE uint32_t divide(uint32_t n) const
+	{
+		const uint32_t t { uint32_t((uint64_t(inverse) * n) >> 32) };
+		return (t + ((n - t) >> shift1)) >> shift2;
+	}
+};
 
-		case 3:
-			if (!(good && colobj.inherits("factor") && colobj.inherits("ordered"))) {
-				if (is<NumericVector>(colobj)) {
-					wrnstr += ": type converted from numeric to integer";
-					warn = true;
-					df[colno] = as<IntegerVector>(df[colno]);
-					good = true;
-				}
-				if (good) {
-					const vector<int>& v = as<vector<int>>(colobj);   
-					auto minmax = std::minmax_element(v.begin(), v.end());
-					good = !(0 > *minmax.first || 1 < *minmax.second);
-				}
-			}
-			errstr += " neither an ordered factor nor an integer vector with all values either 0 or 1";
-			break;
+// adjust() compiled for cap and modulate each zero or not, branch-free on the magnitude
+template<bool Cap, bool Mod>
+struct Adjuster {
+	uint32_t cap, bias;
+	Divisor divisor;
+	Adjuster(int cap, int modulate) : cap(cap), bias(modulate - 1), divisor(Mod ? Divisor(modulate) : Divisor()) {}
+	TRANSITION_INLINE int operator()(int diff) const
+	{
+		uint32_t mag { diff < 0 ? 0u - uint32_t(diff) : uint32_t(diff) };
+		if (Mod)
+			mag = divisor.divide(mag + bias);
+		if (Cap)
+			mag = std::min(mag, cap);
+		return int(diff < 0 ? 0u - mag : mag);
+	}
+};
 
-			default:
-				stop("Transitiondata::typechecker<T>(int, int) my bad");
+// Replace each adjacent result by the transition from it to the corresponding result, or if forward,
+// from the result to it, by the rule of sweep.h. Contiguous and free of branches, the loop vectorises
+template<bool Forward, bool Cap, bool Mod>
+TRANSITION_INLINE inline void adjust_range(const int* __restrict result, int* __restrict adjacent, R_xlen_t n, Adjuster<Cap, Mod> adj)
+{
+	for (R_xlen_t x { 0 }; x < n; ++x) {
+		const int a { adjacent[x] }, b { result[x] };
+		adjacent[x] = Forward ? transition_sweep::transition(b, a, adj) : transition_sweep::transition(a, b, adj);
 	}
-	if (!good)
-		throw std::invalid_argument(errstr);
-	if (warn)
-		warning(wrnstr);
-	return df[colno];
 }
 
+// Transitions of results from or to the adjacent results, in place, dispatching once to the kernel
+// for cap and modulate
+template<bool Forward>
+TRANSITION_INLINE inline void adjust_kernel(const int* result, int* adjacent, R_xlen_t n, int cap, int modulate)
+{
+	const bool mod { modulate > 1 };
+	if (cap && mod)
+		adjust_range<Forward>(result, adjacent, n, Adjuster<true, true>(cap, modulate));
+	else if (cap)
+		adjust_range<Forward>(result, adjacent, n, Adjuster<true, false>(cap, modulate));
+	else if (mod)
+		adjust_range<Forward>(result, adjacent, n, Adjuster<false, true>(cap, modulate));
+	else
+		adjust_range<Forward>(result, adjacent, n, Adjuster<false, false>(cap, modulate));
+}
 
-// Test result for given subject and date
-int Transitiondata::get_result(int subject, double date) const
+TRANSITION_KERNEL
+void adjust_transitions(const int* result, int* adjacent, R_xlen_t n, int cap, int modulate, bool forward)
 {
-//	cout << "@Transitiondata::get_result(int, double) const subject = " << subject << "; date = " << Date(date).getYear() << endl;
-	for (int x { 0 }; x < nrows; ++x)
-		if (id[x] == subject && testdate[x] == date) {
-			return testresult[x];
-		}
-	return NA_INTEGER;
+//	cout << "@adjust_transitions(const int*, int*, R_xlen_t, int, int, bool) n " << n << endl;
+	forward ? adjust_kernel<true>(result, adjacent, n, cap, modulate) : adjust_kernel<false>(result, adjacent, n, cap, modulate);
 }
 
-// All dates for a given subject, sorted
-std::vector<double> Transitiondata::get_id_dates(int target) const
+// Replace each adjacent result by the code of the transition from it to the corresponding result,
+// or if forward, from the result to it, looked up in a column-major table of codes with a row for
+// each level of the earlier result; NA if either is NA. Levels are checked by unsigned comparison,
+// and the table read unconditionally at a clamped cell, so that the loop vectorises as a gather
+template<bool Forward>
+TRANSITION_INLINE inline void code_range(const int* __restrict result, int* __restrict adjacent, R_xlen_t n, const int* __restrict codes,
+	uint32_t nlevels, uint32_t offset)
 {
-//	cout << "@Transitiondata::get_id_dates(int id) const target = " << target << endl;
-	vector<double> out;
+	const uint32_t last { nlevels - 1 };
+	for (R_xlen_t x { 0 }; x < n; ++x) {
+		const uint32_t a { uint32_t(adjacent[x]) - offset }, b { uint32_t(result[x]) - offset };
+		const uint32_t from { Forward ? b : a }, to { Forward ? a : b };
+		const int code { codes[std::min(from, last) + nlevels * std::min(to, last)] };
+		adjacent[x] = (from > last || to > last) ? NA_INTEGER : code;
+	}
+}
+
+// Codes of transitions of results from or to the adjacent results, in place; the pointers are
+// restricted here, where the kernel is compiled, for the gather to be vectorised
+TRANSITION_KERNEL
+void code_transitions(const int* __restrict result, int* __restrict adjacent, R_xlen_t n, const Codebook& book, bool forward)
+{
+//	cout << "@code_transitions(const int*, int*, R_xlen_t, const Codebook&, bool) n " << n << endl;
+	const int* __restrict codes { book.codes };
+	forward ? code_range<true>(result, adjacent, n, codes, book.nlevels, book.offset)
+		: code_range<false>(result, adjacent, n, codes, book.nlevels, book.offset);
+}
+
+
+/// __________________________________________________
+/// Index
+
+// Direction in which rows are already ordered by subject then timepoint: 1 ascending, -1 descending
+// or 0 neither
+int presorted(const int* id, const double* date, int nrows)
+{
+//	cout << "@presorted(const int*, const double*, int) nrows " << nrows << endl;
+	Phase phase("index");
+	bool asc { true }, desc { true };
 	for (int x { 0 }; x < nrows; ++x) {
-		if (id[x] == target)
-			out.push_back(testdate[x]);
+		if (std::isnan(date[x]))
+			stop("testdate NA for subject %i.", id[x]);
+		if (x) {
+			const int sub { (id[x] > id[x - 1]) - (id[x] < id[x - 1]) };
+			const int dt { (date[x] > date[x - 1]) - (date[x] < date[x - 1]) };
+			asc = asc && (sub > 0 || (!sub && dt >= 0));
+			desc = desc && (sub < 0 || (!sub && dt <= 0));
+		}
 	}
-	std::sort(out.begin(), out.end());
-	return out;
+	return asc ? 1 : desc ? -1 : 0;
 }
 
-// most recent previous date for subject
-double Transitiondata::get_prevdate(int subject, double date) const
+// Order rows by (subject, day) packed into a single 64-bit key of just the bits spanned by each,
+// by a stable LSD radix sort of 11-bit digits so rows sharing a key stay in row order; false,
+// leaving order untouched, if dates are not all whole days within the range of int
+bool radix_order(const int* id, const double* date, vector<int>& order, Phase& phase)
 {
-//	cout << "@Transitiondata::get_prevdate(int, double) const subject = " << subject << "; date = " << Date(date).getYear() << endl;
-	auto dates { get_id_dates(subject) };
-	auto it { find(dates.begin(), dates.end(), date) };
-	if (it == dates.end())
-		stop("testdate %s not found for subject %i.", Date(date).format("%Y"), subject);
-	return (it == dates.begin()) ? NA_REAL : *std::prev(it);
+//	cout << "@radix_order(const int*, const double*, vector<int>&, Phase&) nrows " << order.size() << endl;
+	const size_t nrows { order.size() };
+	int idlo { INT_MAX }, idhi { INT_MIN };
+	double daylo { R_PosInf }, dayhi { R_NegInf };
+	for (size_t x { 0 }; x < nrows; ++x) {
+		if (std::floor(date[x]) != date[x])
+			return false;
+		idlo = std::min(idlo, id[x]);
+		idhi = std::max(idhi, id[x]);
+		daylo = std::min(daylo, date[x]);
+		dayhi = std::max(dayhi, date[x]);
+	}
+	if (daylo < INT_MIN || dayhi > INT_MAX)
+		return false;
+	auto bits = [](uint64_t span) { int b { 0 }; for (; span; span >>= 1) ++b; return b; };
+	const int daybits { bits(uint64_t(dayhi - daylo)) };
+	const int keybits { bits(uint64_t(int64_t(idhi) - idlo)) + daybits };
+
+	constexpr int digit { 11 }, radix { 1 << digit };
+	const int passes { (keybits + digit - 1) / digit };
+	vector<uint64_t> keys(nrows), swapkeys(nrows);
+	vector<int> swaprows(nrows);
+	phase.add_bytes(double(nrows) * (2 * sizeof(uint64_t) + sizeof(int)));
+	vector<size_t> counts(size_t(passes) * radix, 0);
+	for (size_t x { 0 }; x < nrows; ++x) {
+		keys[x] = (uint64_t(int64_t(id[x]) - idlo) << daybits) | uint64_t(int64_t(date[x]) - int64_t(daylo));
+		for (int p { 0 }; p < passes; ++p)
+			++counts[p * radix + ((keys[x] >> (p * digit)) & (radix - 1))];
+	}
+	for (int p { 0 }; p < passes; ++p) {
+		size_t* count { &counts[p * radix] };
+		if (count[(keys[0] >> (p * digit)) & (radix - 1)] == nrows)
+			continue;		// all rows share this digit
+		for (size_t b { 0 }, sum { 0 }; b < size_t(radix); ++b) {
+			const size_t c { count[b] };
+			count[b] = sum;
+			sum += c;
+		}
+		for (size_t x { 0 }; x < nrows; ++x) {
+			const size_t to { count[(keys[x] >> (p * digit)) & (radix - 1)]++ };
+			swapkeys[to] = keys[x];
+			swaprows[to] = order[x];
+		}
+		keys.swap(swapkeys);
+		order.swap(swaprows);
+	}
+	return true;
 }
 
-// vector of the most recent previous date by subject
-vector<double> Transitiondata::prev_date() const
+// Row permutation ordered by subject, then timepoint, then original row, radix sorting whole days
+// where possible
+vector<int> order_rows(const int* id, const double* date, int nrows)
 {
-//	cout << "@Transitiondata::prev_date() const\n";
-	vector<double> previous(nrows);
-	transform(id.begin(), id.end(), testdate.begin(), previous.begin(), [this](int id, double date){ return get_prevdate(id, date); });
-	return previous;
+//	cout << "@order_rows(const int*, const double*, int) nrows " << nrows << endl;
+	Phase phase("index", double(nrows) * sizeof(int));
+	constexpr int min_radix { 1024 };	// below which a comparison sort is quicker
+	vector<int> order(nrows);
+	std::iota(order.begin(), order.end(), 0);
+	if (nrows >= min_radix && radix_order(id, date, order, phase))
+		return order;
+	std::sort(order.begin(), order.end(), [id, date](int a, int b) {
+		return (id[a] != id[b]) ? id[a] < id[b] : (date[a] != date[b]) ? date[a] < date[b] : a < b;
+	});
+	return order;
 }
 
-// vector of the most recent previous result by subject
-vector<int> Transitiondata::prev_result() const
+// End of the run of rows sharing subject and timepoint from index position k, and its first kept row,
+// or -1 if none is kept, as in sweep.h
+template<class Rows, class K>
+inline int kept_run(const int* id, const double* date, Rows rows, int k, int last, int& end, K keep)
 {
-//	cout << "@Transitiondata::prev_result() const\n";	
-	auto prevdate { prev_date() };
-	vector<int> prevres(nrows);
-	transform(id.begin(), id.end(), prevdate.begin(), prevres.begin(), [this](int id, double date){ return get_result(id, date); });
-	return prevres;
+//	cout << "@kept_run<Rows, K>(const int*, const double*, Rows, int, int, int&, K) k " << k << endl;
+	const int first { rows(k) };
+	const int at { transition_sweep::run_of(k, last, end,
+		[=](int j) { return id[rows(j)] == id[first] && date[rows(j)] == date[first]; }, rows, keep) };
+	return at < 0 ? -1 : rows(at);
 }
 
+// Visit rows at index positions [begin, last) in order, passing each row together with the first
+// row of the subject's previous timepoint, or -1 if none; rows sharing subject and timepoint form a
+// single run, and begin must fall on the first row of a subject. Only runs with a kept row serve as
+// previous timepoints, represented by their first kept row, e.g. to carry forward the last result
+// that is not missing
+template<class Rows, class F, class K>
+void sweep_runs(const int* id, const double* date, Rows rows, F f, int begin, int last, K keep)
+{
+//	cout << "@sweep_runs<Rows, F, K>(const int*, const double*, Rows, F, int, int, K) begin " << begin << "; last " << last << endl;
+	int prev { -1 };
+	for (int k { begin }, end; k < last; k = end) {
+		const int first { rows(k) };
+		const int rep { kept_run(id, date, rows, k, last, end, keep) };
+		for (int j { k }; j < end; ++j)
+			f(rows(j), prev);
+		if (!(end < last && id[rows(end)] == id[first]))
+			prev = -1;
+		else if (rep >= 0)
+			prev = rep;
+	}
+}
 
-// Add transitions column to data frame
-DataFrame Transitiondata::add_transition(const char* colname, int cap, int modulate)
+template<class Rows, class F>
+void sweep_runs(const int* id, const double* date, Rows rows, F f, int begin, int last)
 {
-//	cout << "@Transitiondata::add_transition(int)\n";
-	if (df.containsElementNamed(colname))
-		stop("Data frame already has column named \"%s\", try another name", colname);
- 	df.push_back(get_transition(cap, modulate), colname);
-	return df;
+	sweep_runs(id, date, rows, f, begin, last, KeepAll());
 }
 
+// As sweep_runs(), but passing each row with the first rows of both the subject's previous and next
+// timepoints, or -1 if none; each run is emitted once the following run has been found
+template<class Rows, class F>
+void sweep_adjacent(const int* id, const double* date, Rows rows, F f, int begin, int last)
+{
+//	cout << "@sweep_adjacent<Rows, F>(const int*, const double*, Rows, F, int, int) begin " << begin << "; last " << last << endl;
+	auto run_end = [=](int k, int& rep) {
+		int end;
+		rep = kept_run(id, date, rows, k, last, end, KeepAll());
+		return end;
+	};
+	int prev { -1 }, rep { -1 };
+	for (int k { begin }, end { (begin < last) ? run_end(begin, rep) : last }; k < last; ) {
+		const bool more { end < last && id[rows(end)] == id[rows(k)] };
+		int next { -1 };
+		const int next_end { more ? run_end(end, next) : end };
+		for (int j { k }; j < end; ++j)
+			f(rows(j), prev, next);
+		prev = more ? rep : -1;
+		k = end;
+		if (more) {
+			end = next_end;
+			rep = next;
+		} else if (k < last)
+			end = run_end(k, rep);
+	}
+}
 
-// Return transitions vector
-vector<int> Transitiondata::get_transition(int cap, int modulate) const
+// As sweep_adjacent(), but only runs with a kept row serve as previous or next timepoints,
+// represented by their first kept row; runs are held until the next kept run of the subject is found
+template<class Rows, class F, class K>
+void sweep_adjacent(const int* id, const double* date, Rows rows, F f, int begin, int last, K keep)
 {
-//	cout << "@Transitiondata::get_transition(int) cap = " << cap << "; modulate = " << modulate << endl;
-	if (cap < 0)
-		throw std::invalid_argument("\"cap\" less than zero");
-	if (modulate < 0)
-		throw std::invalid_argument("\"modulate\" less than zero");
-	auto previous { prev_result() };
-	std::vector<int> transitions(nrows);
-	transform(previous.begin(), previous.end(), testresult.begin(), transitions.begin(),
-		[cap, modulate](int prev, int curr) { return (NA_INTEGER == prev) ? NA_INTEGER : adjust(curr - prev, cap, modulate); }
-	);
-	return transitions;
+//	cout << "@sweep_adjacent<Rows, F, K>(const int*, const double*, Rows, F, int, int, K) begin " << begin << "; last " << last << endl;
+	struct Run { int begin, end, prev; };
+	vector<Run> pending;
+	auto flush = [&](int next) {
+		for (const Run& run : pending)
+			for (int j { run.begin }; j < run.end; ++j)
+				f(rows(j), run.prev, next);
+		pending.clear();
+	};
+	int prev { -1 };
+	for (int k { begin }, end; k < last; k = end) {
+		const int first { rows(k) };
+		const int rep { kept_run(id, date, rows, k, last, end, keep) };
+		const bool kept { rep >= 0 };
+		if (kept)
+			flush(rep);
+		pending.push_back({ k, end, prev });
+		if (kept)
+			prev = rep;
+		if (!(end < last && id[rows(end)] == id[first])) {
+			flush(-1);
+			prev = -1;
+		}
+	}
 }
 
+// As sweep_runs(), but passing each row with the first rows of up to depth of the subject's previous
+// timepoints, most recent first, or -1 for any lacking
+template<class Rows, class F>
+void sweep_lags(const int* id, const double* date, Rows rows, F f, int depth, int begin, int last)
+{
+//	cout << "@sweep_lags<Rows, F>(const int*, const double*, Rows, F, int, int, int) depth " << depth << endl;
+	vector<int> prevs(depth, -1);
+	for (int k { begin }, end; k < last; k = end) {
+		const int first { rows(k) };
+		const int rep { kept_run(id, date, rows, k, last, end, KeepAll()) };
+		for (int j { k }; j < end; ++j)
+			f(rows(j), prevs.data());
+		if (end < last && id[rows(end)] == id[first]) {
+			std::move_backward(prevs.begin(), prevs.end() - 1, prevs.end());
+			prevs[0] = rep;
+		} else
+			std::fill(prevs.begin(), prevs.end(), -1);
+	}
+}
 
-/// __________________________________________________
-/// Auxilliary
-inline IntegerVector prevres_intvec(DataFrame object, const char* subject, const char* timepoint, const char* result)
+// Split the index into contiguous blocks of whole subjects, one for each of up to the given number
+// of threads, calling block(t, begin, last) for block t on its own thread; an exception thrown by any
+// block is rethrown here once all threads have joined
+template<class Rows, class B>
+void for_blocks(const int* id, Rows rows, int nrows, B block, int threads)
 {
-//	cout << "@prevres_intvec(DataFrame, const char*, const char*, const char*) subject " << subject
-//		 << "; timepoint " << timepoint << "; result " << result << endl;
-	int testcol { colpos(object, result) };
-    RObject colobj { object[testcol] };
-	IntegerVector intvec(wrap(vector<int>(Transitiondata(object, colpos(object, subject), colpos(object, timepoint), testcol).prev_result())));
-	if (colobj.inherits("factor") && colobj.inherits("ordered"))
-		intvec.attr("class") = CharacterVector::create("factor", "ordered");
-	intvec.attr("levels") = colobj.attr("levels");
-	return intvec;
+//	cout << "@for_blocks<Rows, B>(const int*, Rows, int, B, int) threads " << threads << endl;
+	Phase phase("sweep");
+	constexpr int min_rows { 16384 };	// per thread, below which threads cost more than they save
+	const int nblocks { std::max(1, std::min(threads, nrows / min_rows)) };
+	vector<int> cuts { 0 };
+	for (int t { 1 }; t < nblocks; ++t) {
+		int k { std::max(int(int64_t(nrows) * t / nblocks), cuts.back()) };
+		while (k < nrows && id[rows(k)] == id[rows(k - 1)])
+			++k;
+		cuts.push_back(k);
+	}
+	cuts.push_back(nrows);
+	vector<std::exception_ptr> errors(nblocks);
+	auto guarded = [&](int t) {
+		try {
+			block(t, cuts[t], cuts[t + 1]);
+		} catch (...) {
+			errors[t] = std::current_exception();
+		}
+	};
+	vector<std::thread> pool;
+	pool.reserve(nblocks);
+	int t { 1 };
+	try {
+		for (; t < nblocks; ++t)
+			pool.emplace_back(guarded, t);
+	} catch (std::system_error&) {
+		for (; t < nblocks; ++t)		// no more threads available, finish the remainder here
+			guarded(t);
+	}
+	guarded(0);
+	for (auto& th : pool)
+		th.join();
+	for (auto& e : errors)
+		if (e)
+			std::rethrow_exception(e);
 }
 
+// Sweep the whole index on up to the given number of threads, each taking a contiguous block of
+// subjects; f must be safe to call concurrently for different rows
+template<class Rows, class F, class K>
+void sweep_parallel(const int* id, const double* date, Rows rows, int nrows, F f, int threads, K keep)
+{
+//	cout << "@sweep_parallel<Rows, F, K>(const int*, const double*, Rows, int, F, int, K) threads " << threads << endl;
+	for_blocks(id, rows, nrows, [=](int, int begin, int last) { sweep_runs(id, date, rows, f, begin, last, keep); }, threads);
+}
 
-/// __________________________________________________
-/// Exported
+// Index positions [first, last) of a subject's rows
+template<class Rows>
+std::pair<int, int> subject_span(const int* id, Rows rows, int nrows, int subject)
+{
+//	cout << "@subject_span<Rows>(const int*, Rows, int, int) subject " << subject << endl;
+	auto bound = [&](bool upper) {
+		int lo { 0 }, hi { nrows };
+		while (lo < hi) {
+			const int mid { lo + (hi - lo) / 2 };
+			if (upper ? id[rows(mid)] <= subject : id[rows(mid)] < subject)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	};
+	return { bound(false), bound(true) };
+}
 
-//' @title
+// Number of threads to use, 0 requesting the package default set by option "Transition.threads"
+int thread_count(int threads)
+{
+//	cout << "@thread_count(int) threads " << threads << endl;
+	if (threads < 0)
+		throw std::invalid_argument("\"threads\" less than zero");
+	if (!threads) {
+		SEXP opt { Rf_GetOption1(Rf_install("Transition.threads")) };
+		threads = Rf_isNull(opt) ? 1 : Rf_asInteger(opt);
+		if (threads == NA_INTEGER || threads < 1)
+			throw std::invalid_argument("option \"Transition.threads\" not a positive integer");
+	}
+	return threads;
+}
+
+
+/// __________________________________________________
+/// Class Transitiondata
+
+// Call g with the accessor for rows in subject and timepoint order, direct if already sorted, else
+// via the permutation
+template<class G>
+void Transitiondata::visit_rows(G g) const
+{
+//	cout << "@Transitiondata::visit_rows<G>(G) const sorted " << sorted << endl;
+	switch (sorted) {
+		case 1:
+			return g(Ascending {});
+		case -1:
+			return g(Descending { nrows - 1 });
+		default:
+			return g(Permuted { order.data() });
+	}
+}
+
+// Sweep rows in subject and timepoint order
+template<class F, class K>
+void Transitiondata::sweep(F f, int threads, K keep) const
+{
+//	cout << "@Transitiondata::sweep<F, K>(F, int, K) const\n";
+	visit_rows([&](auto rows) { sweep_parallel(id.begin(), testdate.begin(), rows, nrows, f, threads, keep); });
+}
+
+// Sweep rows in subject and timepoint order, with the first rows of up to depth previous timepoints
+template<class F>
+void Transitiondata::sweep_lagged(F f, int depth, int threads) const
+{
+//	cout << "@Transitiondata::sweep_lagged<F>(F, int, int) const depth " << depth << endl;
+	const int* subj { id.begin() };
+	const double* date { testdate.begin() };
+	visit_rows([&](auto rows) {
+		for_blocks(subj, rows, nrows, [&](int, int begin, int last) { sweep_lags(subj, date, rows, f, depth, begin, last); }, threads);
+	});
+}
+
+// Sweep rows in subject and timepoint order, with the first rows of both previous and next timepoints
+template<class F>
+void Transitiondata::sweep_both(F f, int threads) const
+{
+//	cout << "@Transitiondata::sweep_both<F>(F, int) const\n";
+	const int* subj { id.begin() };
+	const double* date { testdate.begin() };
+	visit_rows([&](auto rows) {
+		for_blocks(subj, rows, nrows, [&](int, int begin, int last) { sweep_adjacent(subj, date, rows, f, begin, last); }, threads);
+	});
+}
+
+// As sweep_both(), but with previous and next timepoints restricted to kept rows
+template<class F, class K>
+void Transitiondata::sweep_both(F f, int threads, K keep) const
+{
+//	cout << "@Transitiondata::sweep_both<F, K>(F, int, K) const\n";
+	const int* subj { id.begin() };
+	const double* date { testdate.begin() };
+	visit_rows([&](auto rows) {
+		for_blocks(subj, rows, nrows, [&](int, int begin, int last) { sweep_adjacent(subj, date, rows, f, begin, last, keep); }, threads);
+	});
+}
+
+// Visitor passing f each row with its previous timepoint, or -1 if that is outside the window
+template<class F>
+auto Transitiondata::within(F f, const Window& window) const
+{
+	const double* date { testdate.begin() };
+	return [=](int row, int prev) { f(row, (prev < 0 || window.excludes(date[row] - date[prev])) ? -1 : prev); };
+}
+
+// Visitor passing f each row with its previous and next timepoints, either -1 if outside the window
+template<class F>
+auto Transitiondata::within_both(F f, const Window& window) const
+{
+	const double* date { testdate.begin() };
+	return [=](int row, int prev, int next) {
+		f(row, (prev < 0 || window.excludes(date[row] - date[prev])) ? -1 : prev,
+			(next < 0 || window.excludes(date[next] - date[row])) ? -1 : next);
+	};
+}
+
+// As sweep(), but with previous timepoints outside the window treated as absent
+template<class F>
+void Transitiondata::sweep_within(F f, const Window& window, int threads) const
+{
+//	cout << "@Transitiondata::sweep_within<F>(F, const Window&, int) const\n";
+	window.all() ? sweep(f, threads) : sweep(within(f, window), threads);
+}
+
+template<class F, class K>
+void Transitiondata::sweep_within(F f, const Window& window, int threads, K keep) const
+{
+//	cout << "@Transitiondata::sweep_within<F, K>(F, const Window&, int, K) const\n";
+	window.all() ? sweep(f, threads, keep) : sweep(within(f, window), threads, keep);
+}
+
+// As sweep_both(), but with previous and next timepoints outside the window treated as absent
+template<class F>
+void Transitiondata::sweep_both_within(F f, const Window& window, int threads) const
+{
+//	cout << "@Transitiondata::sweep_both_within<F>(F, const Window&, int) const\n";
+	window.all() ? sweep_both(f, threads) : sweep_both(within_both(f, window), threads);
+}
+
+template<class F, class K>
+void Transitiondata::sweep_both_within(F f, const Window& window, int threads, K keep) const
+{
+//	cout << "@Transitiondata::sweep_both_within<F, K>(F, const Window&, int, K) const\n";
+	window.all() ? sweep_both(f, threads, keep) : sweep_both(within_both(f, window), threads, keep);
+}
+
+// Sweep rows in subject and timepoint order, each block of subjects with its own visitor make(t)
+template<class M>
+void Transitiondata::sweep_blocks(M make, int threads) const
+{
+//	cout << "@Transitiondata::sweep_blocks<M>(M, int) const\n";
+	const int* subj { id.begin() };
+	const double* date { testdate.begin() };
+	visit_rows([&](auto rows) {
+		for_blocks(subj, rows, nrows, [&](int t, int begin, int last) { sweep_runs(subj, date, rows, make(t), begin, last); }, threads);
+	});
+}
+
+// Order in which rows were presented
+const char* Transitiondata::presorted() const
+{
+//	cout << "@Transitiondata::presorted() const\n";
+	return (sorted > 0) ? "ascending" : sorted ? "descending" : "none";
+}
+
+// Ctor auxilliary function, encoding a character subject column, else checking its type
+IntegerVector Transitiondata::key_codes(int colno, CharacterVector& labels)
+{
+//	cout << "@Transitiondata::key_codes(int, CharacterVector&) colno " << colno << endl;
+	if (STRSXP != TYPEOF(df[colno]))
+		return typechecker<IntegerVector>(colno, 1);
+	Phase phase("validate");
+	return encode_strings(df[colno], labels);
+}
+
+// Ctor auxilliary function, combining several subject columns into a single key by hashing the
+// codes of each column in turn with the groups of those before; groups are then numbered from 1
+// in order of the codes of their columns, so rows ordered by these columns are ordered by key
+IntegerVector Transitiondata::subject_codes()
+{
+//	cout << "@Transitiondata::subject_codes() " << idcols.size() << " columns\n";
+	if (!composite())
+		return key_codes(idcol, idlabels);
+	vector<IntegerVector> cols;
+	vector<CharacterVector> labels(idcols.size());
+	for (size_t k { 0 }; k < idcols.size(); ++k)
+		cols.push_back(key_codes(idcols[k], labels[k]));
+
+	Phase phase("index", double(nrows) * sizeof(int));
+	vector<int> group(nrows, 0);
+	int ngroups { 1 };
+	for (const IntegerVector& col : cols) {
+		std::unordered_map<uint64_t, int> seen;
+		seen.reserve(std::min(size_t(nrows), size_t(ngroups) * 16));
+		int next { 0 };
+		for (int x { 0 }; x < nrows; ++x) {
+			const uint64_t key { (uint64_t(uint32_t(group[x])) << 32) | uint32_t(col[x]) };
+			const auto found { seen.try_emplace(key, next) };
+			if (found.second)
+				++next;
+			group[x] = found.first->second;
+		}
+		ngroups = next;
+	}
+	vector<int> first(ngroups, -1);
+	for (int x { 0 }; x < nrows; ++x)
+		if (first[group[x]] < 0)
+			first[group[x]] = x;
+	vector<int> rank(ngroups);
+	std::iota(rank.begin(), rank.end(), 0);
+	std::sort(rank.begin(), rank.end(), [&](int a, int b) {
+		for (const IntegerVector& col : cols)
+			if (col[first[a]] != col[first[b]])
+				return col[first[a]] < col[first[b]];
+		return false;
+	});
+	vector<int> code_of(ngroups), keyrows(ngroups);
+	for (int r { 0 }; r < ngroups; ++r) {
+		code_of[rank[r]] = r + 1;
+		keyrows[r] = first[rank[r]] + 1;
+	}
+	IntegerVector codes { new_vector<IntegerVector>(nrows) };
+	for (int x { 0 }; x < nrows; ++x)
+		codes[x] = code_of[group[x]];
+
+	// Values of subject columns for each key, and labels joined as by interaction()
+	const CharacterVector names { df.names() };
+	idlabels = CharacterVector(ngroups);
+	vector<string> joined(ngroups);
+	for (size_t k { 0 }; k < idcols.size(); ++k) {
+		const RObject values { select_codes(df[idcols[k]], keyrows) };
+		idkeys.push_back(values, string(names[idcols[k]]));
+		const CharacterVector levels { Rf_isFactor(values) ? CharacterVector(values.attr("levels")) : CharacterVector() };
+		for (int r { 0 }; r < ngroups; ++r) {
+			const int code { (STRSXP == TYPEOF(values)) ? 0 : INTEGER(values)[r] };
+			const string label { (STRSXP == TYPEOF(values)) ? (NA_STRING == STRING_ELT(values, r) ? "NA" : CHAR(STRING_ELT(values, r)))
+				: NA_INTEGER == code ? "NA" : levels.size() ? string(levels[code - 1]) : std::to_string(code) };
+			joined[r] += k ? "." + label : label;
+		}
+	}
+	for (int r { 0 }; r < ngroups; ++r)
+		idlabels[r] = joined[r];
+	idkeys.attr("row.names") = IntegerVector::create(NA_INTEGER, -ngroups);
+	idkeys.attr("class") = "data.frame";
+	return codes;
+}
+
+// Ctor auxilliary function
+template<typename T>
+T Transitiondata::typechecker(int colno, int arg)
+{	
+//	cout << "@Transitiondata::typechecker<T>(int, int) colno " << colno << "; arg " << arg << endl;
+	Phase phase("validate");
+	std::string errstr("column `");
+	errstr += vector<string>(df.names())[colno] + "`";
+	std::string wrnstr(errstr);
+	RObject colobj { df[colno] };
+	bool good = is<T>(df[colno]);
+	bool warn = false;
+	switch (arg) {
+		case 0:
+			if (!good) errstr += " not of class data.frame";
+			break;
+
+		case 1:
+			if (!good) errstr += " not an integer, factor or character";
+			break;
+
+		case 2:
+			if (!good) {
+				if (is<IntegerVector>(colobj) && !colobj.inherits("factor")) {
+					wrnstr += colobj.inherits("Date") ? ": Date converted from integer to numeric" : ": timepoint converted from integer to numeric";
+					warn = true;
+					df[colno] = as<NumericVector>(df[colno]);
+					phase.add_bytes(Rf_xlength(df[colno]) * sizeof(double));
+					good = true; 
+				}
+				errstr += " not of class Date or POSIXct, nor numeric";
+			}
+			break;
+
+		case 3:
+			if (!(good && colobj.inherits("factor") && colobj.inherits("ordered"))) {
+				if (is<NumericVector>(colobj)) {
+					wrnstr += ": type converted from numeric to integer";
+					warn = true;
+					df[colno] = as<IntegerVector>(df[colno]);
+					phase.add_bytes(Rf_xlength(df[colno]) * sizeof(int));
+					good = true;
+				}
+				if (good) {
+					const int* v { INTEGER(df[colno]) };
+					const R_xlen_t len { Rf_xlength(df[colno]) };
+					auto minmax = std::minmax_element(v, v + len);
+					good = !len || !(0 > *minmax.first || 1 < *minmax.second);
+				}
+			}
+			errstr += " neither an ordered factor nor an integer vector with all values either 0 or 1";
+			break;
+
+			default:
+				stop("Transitiondata::typechecker<T>(int, int) my bad");
+	}
+	if (!good)
+		throw std::invalid_argument(errstr);
+	if (warn)
+		warning(wrnstr);
+	return df[colno];
+}
+
+
+// vector of the most recent previous date by subject, filled in place as the R vector returned
+NumericVector Transitiondata::prev_date(int threads) const
+{
+//	cout << "@Transitiondata::prev_date(int) const threads " << threads << endl;
+	NumericVector previous { new_vector<NumericVector>(nrows) };
+	const double* date { testdate.begin() };
+	double* out { previous.begin() };
+	sweep([date, out](int row, int prev){ out[row] = (prev < 0) ? NA_REAL : date[prev]; }, threads);
+	date_attrs(previous, testdate);
+	return previous;
+}
+
+// vector of the most recent previous result by subject
+IntegerVector Transitiondata::prev_result(int threads) const
+{
+//	cout << "@Transitiondata::prev_result(int) const threads " << threads << endl;
+	IntegerVector prevres { new_vector<IntegerVector>(nrows) };
+	const int* result { testresult.begin() };
+	int* out { prevres.begin() };
+	sweep([result, out](int row, int prev){ out[row] = (prev < 0) ? NA_INTEGER : result[prev]; }, threads);
+	return prevres;
+}
+
+
+// vector of the next date by subject
+NumericVector Transitiondata::next_date(int threads) const
+{
+//	cout << "@Transitiondata::next_date(int) const threads " << threads << endl;
+	NumericVector following { new_vector<NumericVector>(nrows) };
+	const double* date { testdate.begin() };
+	double* out { following.begin() };
+	sweep_both([date, out](int row, int, int next){ out[row] = (next < 0) ? NA_REAL : date[next]; }, threads);
+	date_attrs(following, testdate);
+	return following;
+}
+
+
+// vector of the next result by subject
+IntegerVector Transitiondata::next_result(int threads) const
+{
+//	cout << "@Transitiondata::next_result(int) const threads " << threads << endl;
+	IntegerVector nextres { new_vector<IntegerVector>(nrows) };
+	const int* result { testresult.begin() };
+	int* out { nextres.begin() };
+	sweep_both([result, out](int row, int, int next){ out[row] = (next < 0) ? NA_INTEGER : result[next]; }, threads);
+	return nextres;
+}
+
+
+// Values of the first row of the previous timepoint at each lag, as a list of vectors
+template<int RTYPE>
+List Transitiondata::lagged(const IntegerVector& lag, const Vector<RTYPE>& values, int threads) const
+{
+//	cout << "@Transitiondata::lagged<RTYPE>(const IntegerVector&, const Vector<RTYPE>&, int) const\n";
+	using T = typename traits::storage_type<RTYPE>::type;
+	if (!lag.size())
+		throw std::invalid_argument("\"lag\" empty");
+	const vector<int> lags(lag.begin(), lag.end());
+	int depth { 0 };
+	for (int k : lags) {
+		if (NA_INTEGER == k || k < 1)
+			throw std::invalid_argument("\"lag\" not all positive integers");
+		depth = std::max(depth, k);
+	}
+	List out(lags.size());
+	vector<T*> cols;
+	for (size_t k { 0 }; k < lags.size(); ++k) {
+		Vector<RTYPE> col { new_vector<Vector<RTYPE>>(nrows) };
+		cols.push_back(col.begin());
+		out[k] = col;
+	}
+	const T* vals { values.begin() };
+	const T na { traits::get_na<RTYPE>() };
+	sweep_lagged(
+		[&](int row, const int* prevs) {
+			for (size_t k { 0 }; k < lags.size(); ++k) {
+				const int prev { prevs[lags[k] - 1] };
+				cols[k][row] = (prev < 0) ? na : vals[prev];
+			}
+		}, depth, threads
+	);
+	return out;
+}
+
+// Previous dates at each lag, as a vector for a single lag, else a data frame
+RObject Transitiondata::prev_dates(const IntegerVector& lag, int threads) const
+{
+//	cout << "@Transitiondata::prev_dates(const IntegerVector&, int) const\n";
+	const List cols { lagged(lag, testdate, threads) };
+	for (int k { 0 }; k < cols.size(); ++k) {
+		NumericVector col(cols[k]);
+		date_attrs(col, testdate);
+	}
+	return lag_frame(cols, lag);
+}
+
+// Previous results at each lag, as a vector for a single lag, else a data frame
+RObject Transitiondata::prev_results(const IntegerVector& lag, int threads) const
+{
+//	cout << "@Transitiondata::prev_results(const IntegerVector&, int) const\n";
+	const List cols { lagged(lag, testresult, threads) };
+	for (int k { 0 }; k < cols.size(); ++k) {
+		IntegerVector col(cols[k]);
+		result_attrs(col, testresult);
+	}
+	return lag_frame(cols, lag);
+}
+
+
+// Add transitions column to data frame
+DataFrame Transitiondata::add_transition(const char* colname, int cap, int modulate, bool forward, int threads, bool skip, const Window& window,
+	const IntegerMatrix& codes)
+{
+//	cout << "@Transitiondata::add_transition(const char*, int, int, bool, int, bool, const Window&, const IntegerMatrix&)\n";
+	if (df.containsElementNamed(colname))
+		stop("Data frame already has column named \"%s\", try another name", colname);
+ 	const IntegerVector transitions { get_transition(cap, modulate, forward, threads, skip, window, codes) };
+	Phase phase("wrap");
+ 	df.push_back(transitions, colname);
+	return df;
+}
+
+
+// Return transitions vector, from the previous result to each, or if forward, from each to the next;
+// if skip, missing results are passed over, each transition being from or to the nearest result; any
+// from or to a timepoint outside the window is missing
+IntegerVector Transitiondata::get_transition(int cap, int modulate, bool forward, int threads, bool skip, const Window& window,
+	const IntegerMatrix& codes) const
+{
+//	cout << "@Transitiondata::get_transition(int, int, bool, int, bool, const Window&, const IntegerMatrix&) cap = " << cap << "; modulate = " << modulate << "; forward = " << forward << "; threads = " << threads << endl;
+	if (cap < 0)
+		throw std::invalid_argument("\"cap\" less than zero");
+	if (modulate < 0)
+		throw std::invalid_argument("\"modulate\" less than zero");
+	IntegerVector transitions { new_vector<IntegerVector>(nrows) };
+	transitions_of(testresult.begin(), transitions.begin(), cap, modulate, forward, threads, skip, window, codebook(codes, testresult, cap, modulate));
+	return transitions;
+}
+
+// Codes of transitions between levels of result from a square integer matrix, with rows for the
+// earlier result and columns for the later, checked against the levels; none if the matrix is empty
+Codebook Transitiondata::codebook(const IntegerMatrix& codes, const IntegerVector& result, int cap, int modulate) const
+{
+//	cout << "@Transitiondata::codebook(const IntegerMatrix&, const IntegerVector&, int, int) const\n";
+	if (!codes.size())
+		return Codebook();
+	if (cap || modulate)
+		throw std::invalid_argument("\"codes\" given with non-zero \"cap\" or \"modulate\"");
+	const bool factor { result.inherits("factor") };
+	const CharacterVector levels { factor ? CharacterVector(result.attr("levels")) : CharacterVector::create("0", "1") };
+	const int nlevels = levels.size();
+	if (codes.nrow() != nlevels || codes.ncol() != nlevels)
+		throw std::invalid_argument("\"codes\" not a square matrix with a row and a column for each level of the test results");
+	if (codes.hasAttribute("dimnames")) {
+		const List dimnames(codes.attr("dimnames"));
+		for (R_xlen_t k { 0 }; k < dimnames.size(); ++k) {
+			const SEXP names { dimnames[k] };
+			if (!Rf_isNull(names) && !R_compute_identical(names, levels, 16))
+				throw std::invalid_argument("\"codes\" row or column names not the levels of the test results");
+		}
+	}
+	return Codebook { codes.begin(), uint32_t(nlevels), uint32_t(factor) };
+}
+
+// Fill out with transitions of result: a sweep gathers the previous, or if forward, the next result
+// of each row into out, then the transitions are found, or coded by the codebook, in place in row order
+void Transitiondata::transitions_of(const int* result, int* out, int cap, int modulate, bool forward, int threads, bool skip, const Window& window,
+	const Codebook& book) const
+{
+//	cout << "@Transitiondata::transitions_of(const int*, int*, int, int, bool, int, bool, const Window&, const Codebook&) const\n";
+	const auto kept = [result](int row) { return NA_INTEGER != result[row]; };
+	if (forward) {
+		const auto to_next = [=](int row, int, int next) { out[row] = (next < 0) ? NA_INTEGER : result[next]; };
+		skip ? sweep_both_within(to_next, window, threads, kept) : sweep_both_within(to_next, window, threads);
+	} else {
+		const auto from_prev = [=](int row, int prev) { out[row] = (prev < 0) ? NA_INTEGER : result[prev]; };
+		skip ? sweep_within(from_prev, window, threads, kept) : sweep_within(from_prev, window, threads);
+	}
+	Phase phase("sweep");
+	if (book.codes)
+		code_transitions(result, out, nrows, book, forward);
+	else
+		adjust_transitions(result, out, nrows, cap, modulate, forward);
+}
+
+
+// Data frame with transitions columns added for several result columns
+DataFrame Transitiondata::add_transitions(const vector<int>& testcols, const vector<string>& colnames, int cap, int modulate, bool forward, int threads, bool skip,
+	const Window& window, const IntegerMatrix& codes)
+{
+//	cout << "@Transitiondata::add_transitions(const vector<int>&, const vector<string>&, int, int, bool, int, bool, const Window&, const IntegerMatrix&)\n";
+	for (const string& colname : colnames)
+		if (df.containsElementNamed(colname.c_str()))
+			stop("Data frame already has column named \"%s\", try another name", colname);
+	const List transitions { get_transitions(testcols, cap, modulate, forward, threads, skip, window, codes) };
+	Phase phase("wrap");
+	for (size_t k { 0 }; k < colnames.size(); ++k)
+		df.push_back(transitions[k], colnames[k]);
+	return df;
+}
+
+
+// Data frame of transitions for several result columns, each validated in turn and all found in a
+// single sweep of the shared index, or if skip, one sweep for each column since each passes over
+// its own missing results; named as the result columns
+List Transitiondata::get_transitions(const vector<int>& testcols, int cap, int modulate, bool forward, int threads, bool skip, const Window& window,
+	const IntegerMatrix& codes)
+{
+//	cout << "@Transitiondata::get_transitions(const vector<int>&, int, int, bool, int, bool, const Window&, const IntegerMatrix&) " << testcols.size() << " columns\n";
+	if (cap < 0)
+		throw std::invalid_argument("\"cap\" less than zero");
+	if (modulate < 0)
+		throw std::invalid_argument("\"modulate\" less than zero");
+	const size_t ncols { testcols.size() };
+	vector<IntegerVector> results;
+	vector<Codebook> books;
+	for (int col : testcols) {
+		results.push_back(col == testcol ? testresult : typechecker<IntegerVector>(col, 3));
+		books.push_back(codebook(codes, results.back(), cap, modulate));
+	}
+	List transitions;
+	vector<const int*> inputs;
+	vector<int*> outputs;
+	const vector<string> names(as<vector<string>>(df.names()));
+	for (size_t k { 0 }; k < ncols; ++k) {
+		IntegerVector column { new_vector<IntegerVector>(nrows) };
+		transitions.push_back(column, names[testcols[k]]);
+		inputs.push_back(results[k].begin());
+		outputs.push_back(column.begin());
+	}
+	const int* const* result { inputs.data() };
+	int* const* out { outputs.data() };
+	if (skip)
+		for (size_t k { 0 }; k < ncols; ++k)
+			transitions_of(result[k], out[k], cap, modulate, forward, threads, true, window, books[k]);
+	else {
+		if (forward)
+			sweep_both_within(
+				[=](int row, int, int next) {
+					for (size_t k { 0 }; k < ncols; ++k)
+						out[k][row] = (next < 0) ? NA_INTEGER : result[k][next];
+				}, window, threads
+			);
+		else
+			sweep_within(
+				[=](int row, int prev) {
+					for (size_t k { 0 }; k < ncols; ++k)
+						out[k][row] = (prev < 0) ? NA_INTEGER : result[k][prev];
+				}, window, threads
+			);
+		Phase phase("sweep");
+		for (size_t k { 0 }; k < ncols; ++k)
+			if (books[k].codes)
+				code_transitions(result[k], out[k], nrows, books[k], forward);
+			else
+				adjust_transitions(result[k], out[k], nrows, cap, modulate, forward);
+	}
+	transitions.attr("row.names") = IntegerVector::create(NA_INTEGER, -nrows);
+	transitions.attr("class") = "data.frame";
+	return transitions;
+}
+
+
+// Data frame with any of previous date, previous result, transition, interval, next date, next
+// result and whole days columns added, computed in a single sweep; columns with empty names are
+// omitted, if forward, transitions, intervals and days run from each timepoint to the next, and
+// previous and next timepoints outside the window are treated as absent
+DataFrame Transitiondata::add_columns(const char* prevdatecol, const char* prevrescol, const char* transcol, const char* intervalcol,
+	const char* nextdatecol, const char* nextrescol, const char* dayscol, int cap, int modulate, bool forward, int threads, bool skip,
+	const Window& window) const
+{
+//	cout << "@Transitiondata::add_columns(const char*, const char*, const char*, const char*, const char*, const char*, const char*, int, int, bool, int, bool, const Window&) const\n";
+	if (cap < 0)
+		throw std::invalid_argument("\"cap\" less than zero");
+	if (modulate < 0)
+		throw std::invalid_argument("\"modulate\" less than zero");
+	NumericVector prevdates { new_vector<NumericVector>(*prevdatecol ? nrows : 0) };
+	IntegerVector prevres { new_vector<IntegerVector>(*prevrescol ? nrows : 0) };
+	IntegerVector transitions { new_vector<IntegerVector>(*transcol ? nrows : 0) };
+	NumericVector intervals { new_vector<NumericVector>(*intervalcol ? nrows : 0) };
+	NumericVector nextdates { new_vector<NumericVector>(*nextdatecol ? nrows : 0) };
+	IntegerVector nextres { new_vector<IntegerVector>(*nextrescol ? nrows : 0) };
+	IntegerVector days { new_vector<IntegerVector>(*dayscol ? nrows : 0) };
+	double* pd { *prevdatecol ? prevdates.begin() : nullptr };
+	int* pr { *prevrescol ? prevres.begin() : nullptr };
+	int* tr { *transcol ? transitions.begin() : nullptr };
+	double* iv { *intervalcol ? intervals.begin() : nullptr };
+	double* nd { *nextdatecol ? nextdates.begin() : nullptr };
+	int* nr { *nextrescol ? nextres.begin() : nullptr };
+	int* dy { *dayscol ? days.begin() : nullptr };
+	const double* date { testdate.begin() };
+	const int* result { testresult.begin() };
+	const double unit { testdate.inherits("POSIXct") ? 86400.0 : 1.0 };	// seconds or days
+	auto fill = [=](int row, int prev, int next) {
+		const bool none { prev < 0 };
+		if (pd)
+			pd[row] = none ? NA_REAL : date[prev];
+		if (pr)
+			pr[row] = none ? NA_INTEGER : result[prev];
+		if (nd)
+			nd[row] = (next < 0) ? NA_REAL : date[next];
+		if (nr)
+			nr[row] = (next < 0) ? NA_INTEGER : result[next];
+		if (forward) {
+			if (tr)
+				tr[row] = (next < 0) ? NA_INTEGER : result[next];
+			if (iv)
+				iv[row] = (next < 0) ? NA_REAL : date[next] - date[row];
+			if (dy)
+				dy[row] = (next < 0) ? NA_INTEGER : int(std::floor((date[next] - date[row]) / unit));
+		} else {
+			if (tr)
+				tr[row] = none ? NA_INTEGER : result[prev];
+			if (iv)
+				iv[row] = none ? NA_REAL : date[row] - date[prev];
+			if (dy)
+				dy[row] = none ? NA_INTEGER : int(std::floor((date[row] - date[prev]) / unit));
+		}
+	};
+	const auto kept = [result](int row) { return NA_INTEGER != result[row]; };
+	const auto backward = [fill](int row, int prev) { fill(row, prev, -1); };
+	if (forward || nd || nr)
+		skip ? sweep_both_within(fill, window, threads, kept) : sweep_both_within(fill, window, threads);
+	else
+		skip ? sweep_within(backward, window, threads, kept) : sweep_within(backward, window, threads);
+	if (tr) {
+		Phase phase("sweep");
+		adjust_transitions(result, tr, nrows, cap, modulate, forward);
+	}
+	List cols;
+	if (pd) {
+		date_attrs(prevdates, testdate);
+		cols.push_back(prevdates, prevdatecol);
+	}
+	if (pr) {
+		result_attrs(prevres, testresult);
+		cols.push_back(prevres, prevrescol);
+	}
+	if (tr)
+		cols.push_back(transitions, transcol);
+	if (iv)
+		cols.push_back(intervals, intervalcol);
+	if (nd) {
+		date_attrs(nextdates, testdate);
+		cols.push_back(nextdates, nextdatecol);
+	}
+	if (nr) {
+		result_attrs(nextres, testresult);
+		cols.push_back(nextres, nextrescol);
+	}
+	if (dy)
+		cols.push_back(days, dayscol);
+	return append_columns(df, cols);
+}
+
+
+// Counts of transitions from each level of previous result to each level of result, optionally
+// stratified by subject or by calendar year or month of the later timepoint
+IntegerVector Transitiondata::transition_matrix(const char* by, int threads) const
+{
+//	cout << "@Transitiondata::transition_matrix(const char*, int) const by " << by << endl;
+	const string strata { str_tolower(by) };
+	if (strata != "none" && strata != "subject" && strata != "year" && strata != "month")
+		throw std::invalid_argument("\"by\" not one of \"none\", \"subject\", \"year\" or \"month\"");
+	const bool factor { testresult.inherits("factor") };
+	const CharacterVector levels { factor ? CharacterVector(testresult.attr("levels")) : CharacterVector::create("0", "1") };
+	const int nlevels = levels.size(), offset { factor };
+	const int cells { nlevels * nlevels };
+	const int* subj { id.begin() };
+	const double* date { testdate.begin() };
+	const int* result { testresult.begin() };
+
+	// Periods of days, or of POSIXct times in their time zone
+	int first_period { 0 }, nperiods { 1 };
+	const bool yearly { strata == "year" };
+	const vector<int> local { (strata == "year" || strata == "month") && testdate.inherits("POSIXct") ? local_months(testdate) : vector<int>() };
+	auto period = [yearly, &local, date](int row) {
+		int month;
+		if (local.size())
+			month = local[row];
+		else {
+			const auto ym { year_month(std::floor(date[row])) };
+			month = ym.first * 12 + ym.second - 1;
+		}
+		return yearly ? int(std::floor(month / 12.0)) : month;
+	};
+	if (strata == "year" || strata == "month") {
+		int lo { INT_MAX }, hi { INT_MIN };
+		for (int row { 0 }; row < nrows; ++row) {
+			lo = std::min(lo, period(row));
+			hi = std::max(hi, period(row));
+		}
+		first_period = nrows ? lo : 0;
+		nperiods = nrows ? hi - lo + 1 : 0;
+	}
+
+	// Thread-local accumulators, and subjects in order of accumulation
+	vector<vector<int>> counts(std::max(1, threads)), subjects(counts.size());
+	const bool by_subject { strata == "subject" };
+	const bool by_period { !by_subject && strata != "none" };
+	sweep_blocks(
+		[&](int t) {
+			vector<int>& acc { counts[t] };
+			vector<int>& subs { subjects[t] };
+			if (!by_subject)
+				acc.assign(size_t(cells) * nperiods, 0);
+			return [&, offset, nlevels, cells, first_period](int row, int prev) {
+				if (by_subject && (subs.empty() || subs.back() != subj[row])) {
+					subs.push_back(subj[row]);
+					acc.resize(acc.size() + cells, 0);
+				}
+				if (prev < 0 || NA_INTEGER == result[prev] || NA_INTEGER == result[row])
+					return;
+				const int from { result[prev] - offset }, to { result[row] - offset };
+				if (from < 0 || from >= nlevels || to < 0 || to >= nlevels)
+					return;
+				const size_t slice { by_subject ? acc.size() - cells : by_period ? size_t(period(row) - first_period) * cells : 0 };
+				++acc[slice + from + size_t(nlevels) * to];
+			};
+		}, threads
+	);
+
+	// Merge
+	IntegerVector out;
+	List dimnames { List::create(_["from"] = levels, _["to"] = levels) };
+	if (by_subject) {
+		vector<int> all, subs;
+		for (size_t t { 0 }; t < counts.size(); ++t) {
+			all.insert(all.end(), counts[t].begin(), counts[t].end());
+			subs.insert(subs.end(), subjects[t].begin(), subjects[t].end());
+		}
+		out = wrap(all);
+		out.attr("dim") = IntegerVector::create(nlevels, nlevels, int(subs.size()));
+		CharacterVector sublabels(subs.size());
+		const CharacterVector sublevels { id.inherits("factor") ? CharacterVector(id.attr("levels")) : idlabels };
+		for (size_t x { 0 }; x < subs.size(); ++x) {
+			if (NA_INTEGER == subs[x])
+				sublabels[x] = NA_STRING;
+			else if (sublevels.size())
+				sublabels[x] = sublevels[subs[x] - 1];
+			else
+				sublabels[x] = std::to_string(subs[x]);
+		}
+		dimnames.push_back(sublabels, "subject");
+	} else {
+		vector<int> all(size_t(cells) * nperiods, 0);
+		for (const auto& acc : counts)
+			for (size_t x { 0 }; x < acc.size(); ++x)
+				all[x] += acc[x];
+		out = wrap(all);
+		if (by_period) {
+			out.attr("dim") = IntegerVector::create(nlevels, nlevels, nperiods);
+			CharacterVector labels(nperiods);
+			for (int x { 0 }; x < nperiods; ++x) {
+				const int p { first_period + x };
+				char label[16];
+				if (yearly)
+					snprintf(label, sizeof label, "%d", p);
+				else
+					snprintf(label, sizeof label, "%d-%02d", int(std::floor(p / 12.0)), p - 12 * int(std::floor(p / 12.0)) + 1);
+				labels[x] = label;
+			}
+			dimnames.push_back(labels, strata);
+		} else
+			out.attr("dim") = IntegerVector::create(nlevels, nlevels);
+	}
+	out.attr("dimnames") = dimnames;
+	return out;
+}
+
+
+// Lowest code of a result counted as positive: that of the named level, or by default the level
+// next above the lowest
+int Transitiondata::positive_level(const char* positive) const
+{
+//	cout << "@Transitiondata::positive_level(const char*) const positive " << positive << endl;
+	const bool factor { testresult.inherits("factor") };
+	const CharacterVector levels { factor ? CharacterVector(testresult.attr("levels")) : CharacterVector::create("0", "1") };
+	if (!*positive)
+		return 1 + factor;
+	for (R_xlen_t x { 0 }; x < levels.size(); ++x)
+		if (string(levels[x]) == positive)
+			return x + factor;
+	throw std::invalid_argument("\"positive\" not a level of the test results");
+}
+
+// Tests, timepoints, transitions, runs of the same result and times to first positive result and
+// reversion of each subject, accumulated as the data are swept
+DataFrame Transitiondata::subject_summary(const char* positive, int threads) const
+{
+//	cout << "@Transitiondata::subject_summary(const char*, int) const positive " << positive << endl;
+	struct Summary {
+		int subject, tests, ups, downs, episodes, longest;
+		double first, last, to_positive, to_reversion;
+	};
+	struct Run { int result, length; double positive_at; };
+	const int threshold { positive_level(positive) };
+	const int* subj { id.begin() };
+	const double* date { testdate.begin() };
+	const int* result { testresult.begin() };
+
+	// Thread-local summaries of subjects in order of accumulation, and each thread's current run
+	vector<vector<Summary>> summaries(std::max(1, threads));
+	vector<Run> runs(summaries.size());
+	sweep_blocks(
+		[&](int t) {
+			vector<Summary>& subs { summaries[t] };
+			Run& run { runs[t] };
+			return [&, threshold](int row, int prev) {
+				if (subs.empty() || subs.back().subject != subj[row]) {
+					subs.push_back({ subj[row], 0, 0, 0, 0, 0, date[row], date[row], NA_REAL, NA_REAL });
+					run = { NA_INTEGER, 0, NA_REAL };
+				}
+				Summary& s { subs.back() };
+				++s.tests;
+				s.last = date[row];
+				const int res { result[row] };
+				if (NA_INTEGER == res)
+					return;
+				if (prev >= 0 && NA_INTEGER != result[prev]) {
+					s.ups += res > result[prev];
+					s.downs += res < result[prev];
+				}
+				if (res == run.result)
+					++run.length;
+				else {
+					++s.episodes;
+					run.result = res;
+					run.length = 1;
+				}
+				s.longest = std::max(s.longest, run.length);
+				if (res >= threshold) {
+					if (ISNAN(run.positive_at)) {
+						run.positive_at = date[row];
+						s.to_positive = date[row] - s.first;
+					}
+				} else if (!ISNAN(run.positive_at) && ISNAN(s.to_reversion))
+					s.to_reversion = date[row] - run.positive_at;
+			};
+		}, threads
+	);
+
+	// Merge
+	Phase phase("wrap");
+	vector<Summary> all;
+	for (const auto& subs : summaries)
+		all.insert(all.end(), subs.begin(), subs.end());
+	const int n = all.size();
+	vector<int> subjects(n);
+	IntegerVector tests(new_vector<IntegerVector>(n)), ups(new_vector<IntegerVector>(n)), downs(new_vector<IntegerVector>(n)),
+		episodes(new_vector<IntegerVector>(n)), longest(new_vector<IntegerVector>(n));
+	NumericVector first(new_vector<NumericVector>(n)), last(new_vector<NumericVector>(n)),
+		to_positive(new_vector<NumericVector>(n)), to_reversion(new_vector<NumericVector>(n));
+	for (int x { 0 }; x < n; ++x) {
+		const Summary& s { all[x] };
+		subjects[x] = s.subject;
+		tests[x] = s.tests;
+		ups[x] = s.ups;
+		downs[x] = s.downs;
+		episodes[x] = s.episodes;
+		longest[x] = s.longest;
+		first[x] = s.first;
+		last[x] = s.last;
+		to_positive[x] = s.to_positive;
+		to_reversion[x] = s.to_reversion;
+	}
+	date_attrs(first, testdate);
+	date_attrs(last, testdate);
+	List out(subject_columns(subjects));
+	out.push_back(tests, "tests");
+	out.push_back(first, "first");
+	out.push_back(last, "last");
+	out.push_back(ups, "ups");
+	out.push_back(downs, "downs");
+	out.push_back(episodes, "episodes");
+	out.push_back(longest, "longest");
+	out.push_back(to_positive, "to_positive");
+	out.push_back(to_reversion, "to_reversion");
+	out.attr("row.names") = IntegerVector::create(NA_INTEGER, -n);
+	out.attr("class") = "data.frame";
+	return out;
+}
+
+// Episodes of each subject, runs of consecutive tests with the same result, ignoring missing
+// results, with their first and last timepoints and number of tests
+DataFrame Transitiondata::episodes(int threads) const
+{
+//	cout << "@Transitiondata::episodes(int) const\n";
+	struct Episode { int subject, result, tests; double start, end; };
+	const int* subj { id.begin() };
+	const double* date { testdate.begin() };
+	const int* result { testresult.begin() };
+
+	// Thread-local episodes in order of accumulation
+	vector<vector<Episode>> found(std::max(1, threads));
+	sweep_blocks(
+		[&](int t) {
+			vector<Episode>& eps { found[t] };
+			return [&](int row, int) {
+				const int res { result[row] };
+				if (NA_INTEGER == res)
+					return;
+				if (eps.empty() || eps.back().subject != subj[row] || eps.back().result != res)
+					eps.push_back({ subj[row], res, 0, date[row], date[row] });
+				Episode& e { eps.back() };
+				++e.tests;
+				e.end = date[row];
+			};
+		}, threads
+	);
+
+	// Merge
+	Phase phase("wrap");
+	vector<Episode> all;
+	for (const auto& eps : found)
+		all.insert(all.end(), eps.begin(), eps.end());
+	const int n = all.size();
+	vector<int> subjects(n);
+	IntegerVector results(new_vector<IntegerVector>(n)), tests(new_vector<IntegerVector>(n));
+	NumericVector start(new_vector<NumericVector>(n)), end(new_vector<NumericVector>(n));
+	for (int x { 0 }; x < n; ++x) {
+		const Episode& e { all[x] };
+		subjects[x] = e.subject;
+		results[x] = e.result;
+		tests[x] = e.tests;
+		start[x] = e.start;
+		end[x] = e.end;
+	}
+	result_attrs(results, testresult);
+	date_attrs(start, testdate);
+	date_attrs(end, testdate);
+	List out(subject_columns(subjects));
+	out.push_back(results, string(as<CharacterVector>(df.names())[testcol]));
+	out.push_back(start, "start");
+	out.push_back(end, "end");
+	out.push_back(tests, "tests");
+	out.attr("row.names") = IntegerVector::create(NA_INTEGER, -n);
+	out.attr("class") = "data.frame";
+	return out;
+}
+
+
+// Rows of a subject in index order
+vector<int> Transitiondata::subject_rows(int subject) const
+{
+//	cout << "@Transitiondata::subject_rows(int) const subject " << subject << endl;
+	vector<int> out;
+	visit_rows([&](auto rows) {
+		const auto span { subject_span(id.begin(), rows, nrows, subject) };
+		for (int k { span.first }; k < span.second; ++k)
+			out.push_back(rows(k));
+	});
+	return out;
+}
+
+// First row of a subject's latest timepoint, or -1 if no such subject
+int Transitiondata::last_row(int subject) const
+{
+//	cout << "@Transitiondata::last_row(int) const subject " << subject << endl;
+	int last { -1 };
+	visit_rows([&](auto rows) {
+		const auto span { subject_span(id.begin(), rows, nrows, subject) };
+		if (span.first == span.second)
+			return;
+		last = rows(span.second - 1);
+		for (int k { span.second - 2 }; k >= span.first && testdate[rows(k)] == testdate[last]; --k)
+			last = std::min(last, rows(k));
+	});
+	return last;
+}
+
+// Subjects of these codes, as character, factor or integer like the subject column, or as a data
+// frame of the subject columns for a composite key
+RObject Transitiondata::subject_values(const vector<int>& codes) const
+{
+//	cout << "@Transitiondata::subject_values(const vector<int>&) const\n";
+	if (composite()) {
+		List out;
+		const CharacterVector keynames { idkeys.names() };
+		for (R_xlen_t k { 0 }; k < idkeys.size(); ++k)
+			out.push_back(select_codes(idkeys[k], codes), string(keynames[k]));
+		out.attr("row.names") = IntegerVector::create(NA_INTEGER, -int(codes.size()));
+		out.attr("class") = "data.frame";
+		return out;
+	}
+	if (character_subjects())
+		return select_codes(idlabels, codes);
+	IntegerVector out(wrap(codes));
+	if (id.inherits("factor")) {
+		out.attr("class") = string { "factor" };
+		out.attr("levels") = id.attr("levels");
+	}
+	return out;
+}
+
+// Columns of subjects of these codes, named as the subject column or columns of this data
+List Transitiondata::subject_columns(const vector<int>& codes) const
+{
+//	cout << "@Transitiondata::subject_columns(const vector<int>&) const\n";
+	const RObject subvec { subject_values(codes) };
+	List out;
+	if (composite()) {
+		const List keys(subvec);
+		const CharacterVector keynames { keys.names() };
+		for (R_xlen_t k { 0 }; k < keys.size(); ++k)
+			out.push_back(keys[k], string(keynames[k]));
+	} else
+		out.push_back(subvec, string(as<CharacterVector>(df.names())[idcol]));
+	return out;
+}
+
+// Data frame of subjects, timepoints and results, with the types and names of this data
+DataFrame Transitiondata::state_frame(const vector<int>& subjects, const vector<double>& dates, const vector<int>& results) const
+{
+//	cout << "@Transitiondata::state_frame(const vector<int>&, const vector<double>&, const vector<int>&) const\n";
+	NumericVector datevec(wrap(dates));
+	date_attrs(datevec, testdate);
+	IntegerVector rltvec(wrap(results));
+	result_attrs(rltvec, testresult);
+	const vector<string> names(as<vector<string>>(df.names()));
+	List out(subject_columns(subjects));
+	out.push_back(datevec, names[datecol]);
+	out.push_back(rltvec, names[testcol]);
+	out.attr("row.names") = IntegerVector::create(NA_INTEGER, -int(subjects.size()));
+	out.attr("class") = "data.frame";
+	return out;
+}
+
+// Latest timepoint and result of each subject, ordered by subject
+DataFrame Transitiondata::state() const
+{
+//	cout << "@Transitiondata::state() const\n";
+	vector<int> subjects, results;
+	vector<double> dates;
+	visit_rows([&](auto rows) {
+		for (int k { 0 }, end; k < nrows; k = end) {
+			for (end = k + 1; end < nrows && id[rows(end)] == id[rows(k)]; ++end)
+				;
+			int last { rows(end - 1) };
+			for (int j { end - 2 }; j >= k && testdate[rows(j)] == testdate[last]; --j)
+				last = std::min(last, rows(j));
+			subjects.push_back(id[last]);
+			dates.push_back(testdate[last]);
+			results.push_back(testresult[last]);
+		}
+	});
+	return state_frame(subjects, dates, results);
+}
+
+// Subjects, timepoints and results appended as a block of a columnar file, returning its total rows
+double Transitiondata::write_columns(const char* path, bool append) const
+{
+//	cout << "@Transitiondata::write_columns(const char*, bool) const path " << path << "; append " << append << endl;
+	if (character_subjects() || composite())
+		throw std::invalid_argument("\"subject\" not a single column of integers or factor codes");
+	Phase phase("wrap");
+	transition_stream::append_block(path, nrows, id.begin(), testdate.begin(), testresult.begin(), append);
+	return transition_stream::ColumnarFile(path).rows();
+}
+
+// Previous dates, previous results and transitions for these rows appended to a study whose latest
+// timepoints and results are in state; subjects with rows not following their latest timepoint
+// are reworked from the prepared history of the study, if available
+List Transitiondata::update(const Transitiondata& state, const Transitiondata* history,
+	const char* prevdatecol, const char* prevrescol, const char* transcol, int cap, int modulate) const
+{
+//	cout << "@Transitiondata::update(const Transitiondata&, const Transitiondata*, const char*, const char*, const char*, int, int) const\n";
+	if (cap < 0)
+		throw std::invalid_argument("\"cap\" less than zero");
+	if (modulate < 0)
+		throw std::invalid_argument("\"modulate\" less than zero");
+	if (character_subjects() || state.character_subjects() || (history && history->character_subjects()))
+		throw std::invalid_argument("character subjects not supported, use a factor with the same levels throughout");
+	same_levels(id, state.id, "subject");
+	same_levels(testresult, state.testresult, "result");
+	if (history) {
+		same_levels(history->id, state.id, "history subject");
+		same_levels(history->testresult, state.testresult, "history result");
+	}
+	NumericVector prevdates { new_vector<NumericVector>(nrows) };
+	IntegerVector prevres { new_vector<IntegerVector>(nrows) };
+	IntegerVector transitions { new_vector<IntegerVector>(nrows) };
+	auto assign = [&](int row, double date, int result) {
+		prevdates[row] = date;
+		prevres[row] = result;
+		transitions[row] = transition_sweep::transition(result, testresult[row], [cap, modulate](int diff) { return adjust(diff, cap, modulate); });
+	};
+
+	vector<int> affected;
+	sweep([&](int row, int prev) {
+		if (prev >= 0)
+			return assign(row, testdate[prev], testresult[prev]);
+		const int last { state.last_row(id[row]) };
+		if (last < 0)
+			assign(row, NA_REAL, NA_INTEGER);
+		else if (state.testdate[last] < testdate[row])
+			assign(row, state.testdate[last], state.testresult[last]);
+		else
+			affected.push_back(id[row]);
+	}, 1);
+	affected = get_unique(affected.data(), affected.data() + affected.size());
+
+	// Local rework, merging each affected subject's earlier rows with the new
+	for (int subject : affected) {
+		if (!history)
+			stop("new timepoints for subject %i do not follow its latest in the state, \"history\" required", subject);
+		struct Obs { double date; bool appended; int row; };
+		vector<Obs> obs;
+		for (int row : history->subject_rows(subject))
+			obs.push_back({ history->testdate[row], false, row });
+		for (int row : subject_rows(subject))
+			obs.push_back({ testdate[row], true, row });
+		std::sort(obs.begin(), obs.end(), [](const Obs& a, const Obs& b) {
+			return (a.date != b.date) ? a.date < b.date : (a.appended != b.appended) ? b.appended : a.row < b.row;
+		});
+		const Obs* prev { nullptr };
+		for (size_t k { 0 }, end; k < obs.size(); k = end) {
+			for (end = k + 1; end < obs.size() && obs[end].date == obs[k].date; ++end)
+				;
+			for (size_t j { k }; j < end; ++j)
+				if (obs[j].appended) {
+					if (prev)
+						assign(obs[j].row, prev->date, (prev->appended ? testresult : history->testresult)[prev->row]);
+					else
+						assign(obs[j].row, NA_REAL, NA_INTEGER);
+				}
+			prev = &obs[k];
+		}
+	}
+
+	// Merge latest timepoints into state, both ordered by subject
+	const DataFrame added { this->state() };
+	const IntegerVector addsub { added[0] }, addres { added[2] };
+	const NumericVector adddate { added[1] };
+	const int nstate = state.nrows;
+	vector<int> subjects, results;
+	vector<double> dates;
+	subjects.reserve(nstate + addsub.size());
+	results.reserve(nstate + addsub.size());
+	dates.reserve(nstate + addsub.size());
+	state.visit_rows([&](auto rows) {
+		int a { 0 };
+		for (int k { 0 }; k < nstate || a < addsub.size(); ) {
+			const int r { (k < nstate) ? rows(k) : -1 };
+			if (r >= 0 && (a == addsub.size() || state.id[r] < addsub[a])) {
+				subjects.push_back(state.id[r]);
+				dates.push_back(state.testdate[r]);
+				results.push_back(state.testresult[r]);
+				++k;
+			} else {
+				const bool later { r < 0 || state.id[r] != addsub[a] || state.testdate[r] < adddate[a] };
+				subjects.push_back(addsub[a]);
+				dates.push_back(later ? adddate[a] : state.testdate[r]);
+				results.push_back(later ? addres[a] : state.testresult[r]);
+				if (r >= 0 && state.id[r] == addsub[a])
+					++k;
+				++a;
+			}
+		}
+	});
+
+	result_attrs(prevres, testresult);
+	date_attrs(prevdates, testdate);
+	return List::create(
+		_["data"] = append_columns(df, List::create(_[prevdatecol] = prevdates, _[prevrescol] = prevres, _[transcol] = transitions)),
+		_["state"] = state_frame(subjects, dates, results)
+	);
+}
+
+
+
+/// Reference implementation
+
+// The original engine, rescanning all rows for each row in O(n^2) time, retained as the oracle
+// against which the sweeps above are checked; see inst/validation/differential.R. It reads the raw
+// columns, integer subjects, numeric dates and integer results, sharing nothing with the index.
+
+// Test result for given subject and date
+int Reference::get_result(int subject, double date) const
+{
+//	cout << "@Reference::get_result(int, double) const subject = " << subject << "; date = " << Date(date).getYear() << endl;
+	for (int x { 0 }; x < nrows; ++x)
+		if (id[x] == subject && testdate[x] == date) {
+			return testresult[x];
+		}
+	return NA_INTEGER;
+}
+
+// All dates for a given subject, sorted
+std::vector<double> Reference::get_id_dates(int target) const
+{
+//	cout << "@Reference::get_id_dates(int id) const target = " << target << endl;
+	vector<double> out;
+	for (int x { 0 }; x < nrows; ++x) {
+		if (id[x] == target)
+			out.push_back(testdate[x]);
+	}
+	std::sort(out.begin(), out.end());
+	return out;
+}
+
+// most recent previous date for subject
+double Reference::get_prevdate(int subject, double date) const
+{
+//	cout << "@Reference::get_prevdate(int, double) const subject = " << subject << "; date = " << Date(date).getYear() << endl;
+	auto dates { get_id_dates(subject) };
+	auto it { find(dates.begin(), dates.end(), date) };
+	if (it == dates.end())
+		stop("testdate %s not found for subject %i.", Date(date).format("%Y"), subject);
+	return (it == dates.begin()) ? NA_REAL : *std::prev(it);
+}
+
+// vector of the most recent previous date by subject
+vector<double> Reference::prev_date() const
+{
+//	cout << "@Reference::prev_date() const\n";
+	vector<double> previous(nrows);
+	transform(id.begin(), id.end(), testdate.begin(), previous.begin(), [this](int id, double date){ return get_prevdate(id, date); });
+	return previous;
+}
+
+// vector of the most recent previous result by subject
+vector<int> Reference::prev_result() const
+{
+//	cout << "@Reference::prev_result() const\n";
+	auto prevdate { prev_date() };
+	vector<int> prevres(nrows);
+	transform(id.begin(), id.end(), prevdate.begin(), prevres.begin(), [this](int id, double date){ return get_result(id, date); });
+	return prevres;
+}
+
+// Return transitions vector
+vector<int> Reference::get_transition(int cap, int modulate) const
+{
+//	cout << "@Reference::get_transition(int) cap = " << cap << "; modulate = " << modulate << endl;
+	if (cap < 0)
+		throw std::invalid_argument("\"cap\" less than zero");
+	if (modulate < 0)
+		throw std::invalid_argument("\"modulate\" less than zero");
+	auto previous { prev_result() };
+	std::vector<int> transitions(nrows);
+	// Intended change: the original differenced NA_INTEGER for a missing current result, overflowing;
+	// transitions to a missing result are now NA, as are those from one
+	transform(previous.begin(), previous.end(), testresult.begin(), transitions.begin(),
+		[cap, modulate](int prev, int curr) { return (NA_INTEGER == prev || NA_INTEGER == curr) ? NA_INTEGER : adjust(curr - prev, cap, modulate); }
+	);
+	return transitions;
+}
+
+// Added for lags and next timepoints: date lag distinct timepoints before (or if negative, after)
+// date for subject
+double Reference::get_lagdate(int subject, double date, int lag) const
+{
+//	cout << "@Reference::get_lagdate(int, double, int) const subject = " << subject << "; date = " << Date(date).getYear() << endl;
+	auto dates { get_id_dates(subject) };
+	dates.erase(std::unique(dates.begin(), dates.end()), dates.end());
+	auto it { find(dates.begin(), dates.end(), date) };
+	if (it == dates.end())
+		stop("testdate %s not found for subject %i.", Date(date).format("%Y"), subject);
+	const auto pos { (it - dates.begin()) - lag };
+	return (pos < 0 || pos >= int(dates.size())) ? NA_REAL : dates[pos];
+}
+
+// Previous and next dates and results, transitions from the previous result and to the next, and
+// dates and results lag timepoints back, as plain vectors
+DataFrame Reference::reference(int cap, int modulate, int lag) const
+{
+//	cout << "@Reference::reference(int, int, int) const cap = " << cap << "; modulate = " << modulate << "; lag = " << lag << endl;
+	if (lag < 1 || NA_INTEGER == lag)
+		throw std::invalid_argument("\"lag\" not a positive integer");
+	const NumericVector prevdate(wrap(prev_date()));
+	const IntegerVector prevres(wrap(prev_result())), transitions(wrap(get_transition(cap, modulate)));
+	NumericVector nextdate(nrows), lagdate(nrows);
+	IntegerVector nextres(nrows), lagres(nrows), forward(nrows);
+	auto result_at = [this](int subject, double date) { return ISNAN(date) ? NA_INTEGER : get_result(subject, date); };
+	for (int x { 0 }; x < nrows; ++x) {
+		nextdate[x] = get_lagdate(id[x], testdate[x], -1);
+		lagdate[x] = get_lagdate(id[x], testdate[x], lag);
+		nextres[x] = result_at(id[x], nextdate[x]);
+		lagres[x] = result_at(id[x], lagdate[x]);
+		forward[x] = (NA_INTEGER == nextres[x] || NA_INTEGER == testresult[x]) ? NA_INTEGER : adjust(nextres[x] - testresult[x], cap, modulate);
+	}
+	List out { List::create(
+		_["prev_date"] = prevdate, _["prev_result"] = prevres, _["transition"] = transitions,
+		_["next_date"] = nextdate, _["next_result"] = nextres, _["forward"] = forward,
+		_["lag_date"] = lagdate, _["lag_result"] = lagres
+	) };
+	out.attr("row.names") = IntegerVector::create(NA_INTEGER, -nrows);
+	out.attr("class") = "data.frame";
+	return out;
+}
+
+
+// Unique subjects, timepoints and results, named as their data frame columns
+List Transitiondata::uniques(bool counts) const
+{
+//	cout << "@Transitiondata::uniques(bool) const counts " << counts << endl;
+	Phase phase("uniques");
+	vector<int> subs, subn, tests, testn, daten;
+	vector<double> dates;
+	auto levels_of = [](const IntegerVector& col) { return col.inherits("factor") ? Rf_length(col.attr("levels")) : -1; };
+	unique_codes(id.begin(), id.end(), 1, (composite() || character_subjects()) ? int(idlabels.size()) : levels_of(id), subs, subn);
+	unique_days(testdate.begin(), testdate.end(), dates, daten);
+	const bool factor { testresult.inherits("factor") };
+	unique_codes(testresult.begin(), testresult.end(), factor ? 1 : 0, factor ? levels_of(testresult) : 1, tests, testn);
+	const RObject subvec { subject_values(subs) };
+	NumericVector datevec(wrap(dates));
+	date_attrs(datevec, testdate);
+	IntegerVector rltvec(wrap(tests));
+	rltvec.attr("class") = CharacterVector::create("factor", "ordered");
+	rltvec.attr("levels") = testresult.attr("levels");
+	const vector<string> names(as<vector<string>>(df.names()));
+	if (!counts)
+		return List::create(_[names[idcol]] = subvec, _[names[datecol]] = datevec, _[names[testcol]] = rltvec);
+	return List::create(
+		_[names[idcol]] = value_counts(subvec, subn, names[idcol]),
+		_[names[datecol]] = value_counts(datevec, daten, names[datecol]),
+		_[names[testcol]] = value_counts(rltvec, testn, names[testcol])
+	);
+}
+
+
+/// __________________________________________________
+/// Auxilliary
+inline IntegerVector prevres_intvec(const Transitiondata& td, int threads)
+{
+//	cout << "@prevres_intvec(const Transitiondata&, int)\n";
+	IntegerVector intvec(wrap(td.prev_result(threads)));
+	result_attrs(intvec, td.results());
+	return intvec;
+}
+
+inline IntegerVector prevres_intvec(DataFrame object, const CharacterVector& subject, const char* timepoint, const char* result, int threads)
+{
+//	cout << "@prevres_intvec(DataFrame, const char*, const char*, const char*, int) subject " << subject
+//		 << "; timepoint " << timepoint << "; result " << result << endl;
+	return prevres_intvec(Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)), threads);
+}
+
+// Next results vector with attributes of the results column
+inline IntegerVector nextres_intvec(const Transitiondata& td, int threads)
+{
+//	cout << "@nextres_intvec(const Transitiondata&, int)\n";
+	IntegerVector intvec(wrap(td.next_result(threads)));
+	result_attrs(intvec, td.results());
+	return intvec;
+}
+
+// Single lagged vector, or data frame of lagged vectors with columns named by lag
+inline RObject lag_frame(List cols, const IntegerVector& lag)
+{
+//	cout << "@lag_frame(List, const IntegerVector&)\n";
+	if (1 == cols.size())
+		return cols[0];
+	CharacterVector names(lag.size());
+	for (int k { 0 }; k < lag.size(); ++k)
+		names[k] = "lag" + std::to_string(lag[k]);
+	cols.attr("names") = names;
+	cols.attr("row.names") = IntegerVector::create(NA_INTEGER, -Rf_xlength(cols[0]));
+	cols.attr("class") = "data.frame";
+	return cols;
+}
+
+// Transitiondata held by a handle from prepare_transitions()
+Transitiondata& prepared_data(SEXP prepared)
+{
+//	cout << "@prepared_data(SEXP)\n";
+	if (!Rf_inherits(prepared, "transition_index"))
+		stop("\"prepared\" not a transition index from prepare_transitions()");
+	XPtr<Transitiondata> xp(prepared);
+	if (!xp.get())
+		stop("transition index no longer valid (e.g., restored from a saved session), use prepare_transitions() again");
+	return *xp;
+}
+
+
+/// __________________________________________________
+/// Synthetic data
+
+// Study of subjects with visits each (or if unbalanced, from 1 to 2 * visits - 1), timepoints at
+// random intervals of up to half a year, and results taking a random walk over levels, with rows
+// ordered by subject and timepoint, reversed, or at random; drawn using R's random number generator
+DataFrame synthetic(int subjects, int visits, int levels, const char* order, bool unbalanced)
+{
+//	cout << "@synthetic(int, int, int, const char*, bool) subjects " << subjects << "; visits " << visits << "; levels " << levels << endl;
+	if (subjects < 1 || NA_INTEGER == subjects)
+		throw std::invalid_argument("\"subjects\" not a positive integer");
+	if (visits < 1 || NA_INTEGER == visits)
+		throw std::invalid_argument("\"visits\" not a positive integer");
+	if (levels < 2 || NA_INTEGER == levels)
+		throw std::invalid_argument("\"levels\" less than two");
+	const string ordering { str_tolower(order) };
+	if (ordering != "sorted" && ordering != "reversed" && ordering != "random")
+		throw std::invalid_argument("\"order\" not one of \"sorted\", \"reversed\" or \"random\"");
+	auto draw = [](int n) { return int(unif_rand() * n); };
+
+	vector<int> nvisits(subjects, visits);
+	int64_t total { 0 };
+	for (int& v : nvisits) {
+		if (unbalanced)
+			v = 1 + draw(2 * visits - 1);
+		total += v;
+	}
+	if (total > INT_MAX)
+		throw std::invalid_argument("too many rows in total");
+	const int nrows = total;
+
+	// Position of each generated row, in order of subject and timepoint
+	vector<int> pos(nrows);
+	std::iota(pos.begin(), pos.end(), 0);
+	if (ordering == "reversed")
+		std::reverse(pos.begin(), pos.end());
+	else if (ordering == "random")
+		for (int k { nrows - 1 }; k > 0; --k)
+			std::swap(pos[k], pos[draw(k + 1)]);
+
+	IntegerVector subject(nrows), result(nrows);
+	NumericVector timepoint(nrows);
+	for (int s { 0 }, k { 0 }; s < subjects; ++s) {
+		double day { 10957.0 + draw(3653) };
+		int level { 1 + draw(levels) };
+		for (int v { 0 }; v < nvisits[s]; ++v, ++k) {
+			subject[pos[k]] = s + 1;
+			timepoint[pos[k]] = day;
+			result[pos[k]] = level;
+			day += 1 + draw(183);
+			level = std::clamp(level + draw(3) - 1, 1, levels);
+		}
+	}
+	timepoint.attr("class") = "Date";
+	CharacterVector labels(levels);
+	for (int x { 0 }; x < levels; ++x)
+		labels[x] = std::to_string(x + 1);
+	result.attr("levels") = labels;
+	result.attr("class") = CharacterVector::create("ordered", "factor");
+	List out { List::create(_["subject"] = subject, _["timepoint"] = timepoint, _["result"] = result) };
+	out.attr("row.names") = IntegerVector::create(NA_INTEGER, -nrows);
+	out.attr("class") = "data.frame";
+	return out;
+}
+
+
+/// __________________________________________________
+/// Delimited text
+
+// Rows of a delimited text file with their previous timepoints, previous results and transitions,
+// parsed and swept by transition_csv; subjects as a factor with levels in order of first
+// appearance, timepoints as Dates and results as ordered factor if levels are given
+DataFrame csv_transitions(const char* path, const transition_csv::Options& opt)
+{
+//	cout << "@csv_transitions(const char*, const transition_csv::Options&) path " << path << "; threads " << opt.threads << endl;
+	transition_csv::Table table;
+	{
+		Phase phase("parse");
+		table = transition_csv::read_transitions(path, opt);
+	}
+	const R_xlen_t n = table.rows();
+	Phase phase("wrap");
+	IntegerVector subject { new_vector<IntegerVector>(n) }, result { new_vector<IntegerVector>(n) },
+		prev_result { new_vector<IntegerVector>(n) }, transition { new_vector<IntegerVector>(n) };
+	NumericVector timepoint { new_vector<NumericVector>(n) }, prev_date { new_vector<NumericVector>(n) };
+	std::copy(table.subject.begin(), table.subject.end(), subject.begin());
+	std::copy(table.result.begin(), table.result.end(), result.begin());
+	std::copy(table.prev_result.begin(), table.prev_result.end(), prev_result.begin());
+	std::copy(table.transition.begin(), table.transition.end(), transition.begin());
+	std::copy(table.timepoint.begin(), table.timepoint.end(), timepoint.begin());
+	std::copy(table.prev_date.begin(), table.prev_date.end(), prev_date.begin());
+
+	subject.attr("levels") = table.subjects;
+	subject.attr("class") = "factor";
+	timepoint.attr("class") = "Date";
+	prev_date.attr("class") = "Date";
+	if (opt.levels.size()) {
+		for (IntegerVector* v : { &result, &prev_result }) {
+			v->attr("levels") = opt.levels;
+			v->attr("class") = CharacterVector::create("ordered", "factor");
+		}
+	}
+	List out { List::create(_["subject"] = subject, _["timepoint"] = timepoint, _["result"] = result,
+		_["prev_date"] = prev_date, _["prev_result"] = prev_result, _["transition"] = transition) };
+	out.attr("row.names") = IntegerVector::create(NA_INTEGER, -n);
+	out.attr("class") = "data.frame";
+	const double seconds { table.parse_seconds + table.sweep_seconds };
+	out.attr("timing") = NumericVector::create(_["parse"] = table.parse_seconds, _["sweep"] = table.sweep_seconds,
+		_["rows_per_sec"] = seconds > 0 ? n / seconds : NA_REAL);
+	return out;
+}
+
+
+/// __________________________________________________
+/// Exported
+
+//' @title
 //' Identify Temporal Transitions in Longitudinal Study Data
 //'
 //' @name
-//' Transitions
+//' Transitions
+//'
+//' @description
+//' \code{get_transitions()} identifies temporal transitions in test results for individual
+//' subjects in a longitudinal study.
+//'
+//' \code{add_transitions()} interpolates these transitions into a data frame for further analysis.
+//'
+//' @details
+//' The data can be presented in any order e.g., ordered by \code{subject}, by \code{timepoint},
+//' forwards or backwards in time, or entirely at random, and may have unbalanced designs with different
+//' time points or numbers of test results per subject. However, the \emph{user} is responsible for
+//' ensuring the data contain unique combinations of \code{subject}, \code{timepoint} and \code{result};
+//' if not, outputs will be undefined.
+//'
+//' Time points should be formatted as \code{\link{Dates}}, as \code{\link{POSIXct}} date-times, or as
+//' plain \code{\link{numeric}} values, and included in data frame \code{object} in the column named as
+//' specified by argument \code{timepoint} (see \emph{Note}); previous and next time points are
+//' returned with the same class and time zone.
+//'
+//' Subjects identified by \code{\link{character}} strings are encoded internally, each distinct
+//' string once, and returned as strings; they need not be converted to a \code{\link{factor}} first.
+//'
+//' If \code{subject} names several columns, e.g. \code{c("subject", "assay")} for a panel of assays
+//' in long format, each distinct combination of their values is treated as a separate subject, so
+//' that transitions are found within each assay of each subject in a single call. Combinations are
+//' ordered by the first column, then the second and so on, and are returned as a data frame of these
+//' columns by \code{\link{uniques}()} and \code{\link{transition_state}()}, or labelled as by
+//' \code{\link{interaction}()} by \code{\link{transition_matrix}()}.
+//'
+//' Test results should either be semi-quantitiative, formatted as an
+//' \code{\link[base:ordered]{ordered factor}} (see \emph{Note}), or binary data formatted as an
+//' \code{\link{integer}} (or \code{\link{numeric}}) vector with values of either \code{1} or \code{0},
+//' and included in \code{object} in the data frame column specified by argument \code{result}.
+//'
+//' Temporal transitions in the test \code{results} for each \code{subject} within the \code{object}
+//' \code{\link{data.frame}} are characterised using methods governed by options \code{cap} and
+//' \code{modulate}. If these two parameters are both zero (their defaults), a simple arithmetic
+//' difference between the levels of the present and previous result is calculated. Otherwise, if
+//' the value of \code{modulate} is a positive, non-zero integer, the arithmetic difference is
+//' subjected to integer division by that value. Finally, if \code{cap} is a positive, non-zero
+//' integer, the (possibly modulated) absolute arithmetic difference is capped at that value.
+//'
+//' Missing (\code{NA}) results interrupt chains of transitions: by default, the transitions both from
+//' and to a missing result are \code{NA}. With \code{na = "skip"}, each transition is instead from
+//' the subject's last result that is not missing, or if \code{forward}, to the next such result, and
+//' is \code{NA} only for missing results themselves. The last result that is not missing, and its
+//' timepoint, are carried forward in the same single pass through the data, so rows with missing
+//' results need not be removed beforehand; \code{\link{add_transition_columns}()} likewise reports
+//' previous and next timepoints and results that are not missing.
+//'
+//' Several results recorded for each \code{subject} and \code{timepoint}, e.g. a panel of markers
+//' in separate columns, may be named together in argument \code{result} of \code{get_transitions()}
+//' and \code{add_transitions()}; the rows are then validated and ordered once, and transitions of all
+//' the results are found together in a single pass.
+//'
+//' By default, each transition is from the previous result of the subject to the present one, and
+//' is \code{NA} for the subject's first timepoint. If \code{forward} is \code{TRUE}, each is instead
+//' from the present result to the subject's next, and is \code{NA} for the last timepoint; see also
+//' \code{\link{get_next_result}()}.
+//'
+//' Other schemes of classifying transitions may be given as a matrix of \code{codes}, e.g. coding a
+//' change from a negative to a low positive result as seroconversion. Rows and columns of the matrix
+//' are the levels of the earlier and later results, \code{"0"} and \code{"1"} for binary results,
+//' and any \code{\link{dimnames}} must match those levels in order. The code of each transition is
+//' looked up in the matrix, within the same native pass as the arithmetic difference it replaces;
+//' \code{cap} and \code{modulate} must then be zero. A transition is \code{NA} if either result is
+//' missing, or if its entry in the matrix is \code{NA}.
+//'
+//' Transitions spanning too long (or too short) a time may be excluded during the same pass using
+//' arguments \code{max_gap} and \code{min_gap}: a transition whose previous timepoint, or if
+//' \code{forward}, next timepoint, lies more than \code{max_gap} or less than \code{min_gap} from the
+//' present one is \code{NA}, as for a subject's first timepoint. Gaps are in the units of the
+//' timepoints: days for \code{\link{Dates}}, seconds for \code{\link{POSIXct}}.
+//'
+//' Once the rows are ordered by \code{subject} and \code{timepoint}, the histories of different
+//' subjects are processed independently and, for large data frames, may be shared among
+//' \code{threads}; results are identical whatever the number of threads. Data already ordered by
+//' \code{subject} then \code{timepoint}, ascending or descending, are processed without reordering.
+//'
+//' @family transitions
+//' @seealso
+//' \code{\link{data.frame}}, \code{\link{Dates}}, and \code{\link[base:factor]{ordered factor}}.
+//'
+//' @param object a \code{\link{data.frame}} (or object coercible by \code{\link{as.data.frame}()} to
+//'   a data frame) containing the data to be analysed.
+//'
+//' @param subject \code{\link{character}}, name of the column (of type \code{\link{integer}},
+//'   \code{\link{factor}} or \code{character}) identifying individual study subjects, or names of
+//'   several such columns identifying them in combination (see \emph{Details}); default \code{"subject"}.
+//'
+//' @param timepoint \code{character}, name of the column recording time points (as \code{\link{Dates}},
+//'   \code{\link{POSIXct}} or \code{\link{numeric}}) of testing of subjects; default \code{"timepoint"}.
+//'
+//' @param result \code{character}, name of the column (of type \code{\link[base:factor]{ordered factor}},
+//'   or binary, see \emph{Details}) recording test results, or for \code{get_transitions()} and
+//'   \code{add_transitions()}, names of several such columns; default \code{"result"}.
+//'
+//' @param transition \code{character}, name to be used for a new column (of type
+//'   \code{\link{integer}}) to record transitions; default \code{"transition"}. For several
+//'   \code{result} columns, either one name for each, or a single name to which each result column
+//'   name is appended e.g., \code{"transition_marker1"}.
+//'
+//' @param cap \code{\link{integer}}, required for calculating transitions; default \code{0L}.
+//'
+//' @param modulate \code{\link{integer}}, required for calculating transitions; default \code{0L}.
+//'
+//' @param forward \code{\link{logical}}, whether transitions run from each result to the next,
+//'   rather than from the previous result to each; default \code{FALSE}.
+//'
+//' @param na \code{character}, treatment of missing results: \code{"propagate"}, giving \code{NA}
+//'   for transitions from or to a missing result, or \code{"skip"}, passing over missing results to
+//'   the nearest result that is not missing (see \emph{Details}); default \code{"propagate"}.
+//'
+//' @param min_gap \code{\link{numeric}}, least time between timepoints for a transition between
+//'   them to be found (see \emph{Details}); default \code{0}.
+//'
+//' @param max_gap \code{numeric}, greatest time between timepoints for a transition between them
+//'   to be found; default \code{Inf}, no limit.
+//'
+//' @param codes \code{\link{integer}} \code{\link{matrix}} of codes for transitions, with a row
+//'   for each level of the earlier result and a column for each level of the later (see
+//'   \emph{Details}); default \code{NULL}, giving transitions by \code{cap} and \code{modulate}.
+//'
+//' @param threads \code{\link{integer}}, maximum number of threads to use; default \code{0L}, to use
+//'   the value of \code{\link{options}("Transition.threads")}, or a single thread if that is unset.
+//'
+//' @return
+//'
+//' \item{\code{add_transitions()}}{A \code{\link{data.frame}} based on \code{object}, with an added
+//'    column of type \code{\link{integer}} containing the values of the test result transitions, or
+//'    one such column for each of several \code{result} columns.}
+//'
+//' \item{\code{get_transitions()}}{An \code{\link[base:vector]{integer vector}} of length
+//'    \code{\link{nrow}(object)}, containing the values of the test result transitions ordered in the exact
+//'    sequence of the \code{subject} and \code{timepoint} in \code{object}; or if \code{result} names
+//'    several columns, a \code{\link{data.frame}} of such vectors, named as those columns.}
+//'
+//' @note
+//' Time points represented by \code{\link{integer}} or \code{\link{numeric}} values can be converted
+//'   to R \code{Dates} conveniently using \code{\link{as.Date}()}. If only \emph{year} information is
+//'   available, arbitrary values could be used consistently for month and day e.g., 1st of January of
+//'   each year; likewise, the first day of each month could be used arbitrarily, if only the
+//'   \emph{year} and \emph{month} were known. See vignette 
+//'   \href{../doc/convertDate.pdf}{Converting numeric values to class \code{"Date"}} for examples.
+//'
+//' Quantitive results available as \code{\link{numeric}} data can be converted to a semi-quantitative
+//'   \code{\link[base:factor]{ordered factor}} conveniently using \code{\link{cut}()} (see \emph{examples}).
+//'
+//' @examples
+//'
+//'   # Inspect Blackmore data frame using {base} str()
+//' Blackmore |> str()
+//'
+//'   # {base} hist() gives insights into the "exercise" column,
+//'   #   useful for choosing `breaks` and `labels` in cut() below
+//' hist(Blackmore$exercise, include.lowest = TRUE, plot = FALSE)[1:2]
+//'
+//'   # Tweak Blackmore data frame by converting "age" to dates for the argument
+//'   #   timepoint (using an arbitrary "origin" of 1-Jan-2000), and converting
+//'   #   "exercise" to an ordered factor "result" with {base} cut()
+//' Blackmore <- transform(Blackmore,
+//'     timepoint = as.Date("2000-01-01") + round(age * 365.25),
+//'     result = cut(
+//'         exercise,
+//'         breaks = seq(0, 30, 2),
+//'         labels = paste0("<=", seq(0, 30, 2)[-1]),
+//'         include.lowest = TRUE,
+//'         ordered_result = TRUE
+//'     )
+//' )
+//'
+//'   # subject, timepoint and result arguments now defaults and required types
+//' Blackmore |> str()
+//'
+//'   # Integer vector of test result transitions (defaults: cap = modulate = 0)
+//' get_transitions(Blackmore)
+//'
+//'   # Tabulate values of transitions
+//' get_transitions(Blackmore) |> table()
+//'
+//'   # Effect of cap argument
+//' get_transitions(Blackmore, cap = 6) |> table()
+//'
+//'   # Effect of modulate argument
+//' get_transitions(Blackmore, modulate = 2) |> table()
+//'
+//'   # Transitions of two result columns from one index, as a data frame
+//' get_transitions(transform(Blackmore, result2 = rev(result)), result = c("result", "result2")) |>
+//'     head(10)
+//'
+//'   # Transitions to the next result rather than from the previous one
+//' get_transitions(Blackmore, forward = TRUE) |> head(22)
+//'
+//'   # Custom codes: 1 on rising above 4 hours a week, -1 on falling to 4 or below, else 0
+//' above <- seq_along(levels(Blackmore$result)) > 2
+//' codes <- outer(above, above, function(from, to) as.integer(to) - as.integer(from))
+//' dimnames(codes) <- list(levels(Blackmore$result), levels(Blackmore$result))
+//' get_transitions(Blackmore, codes = codes) |> table()
+//'
+//'   # Add column of test result transitions to data frame
+//' add_transitions(Blackmore) |> head(22)
+//'
+//'   # Showing transitions as either positive (1) or negative (-1)
+//'   #   (defaults to modulate = 0)
+//' add_transitions(Blackmore, cap = 1) |> head(14)
+//'
+//' rm(Blackmore)
+//'
+// [[Rcpp::export]]
+DataFrame add_transitions(
+	DataFrame object,
+	CharacterVector subject = "subject",
+	const char* timepoint = "timepoint",
+	CharacterVector result = "result",
+	CharacterVector transition = "transition",
+	int cap = 0,
+	int modulate = 0,
+	bool forward = false,
+	const char* na = "propagate",
+	double min_gap = 0,
+	double max_gap = R_PosInf,
+	Nullable<IntegerMatrix> codes = R_NilValue,
+	int threads = 0)
+{
+//	cout << "——Rcpp::export——add_transitions(DataFrame, CharacterVector, const char*, CharacterVector, CharacterVector, int, int, bool, const char*, double, double, Nullable<IntegerMatrix>, int) subject " << subject
+//		 << "; timepoint " << timepoint << "; result " << result << "; transition " << transition << endl;
+	try {
+		const vector<int> results { colpos(object, result) };
+		Transitiondata td(object, colpos(object, subject), colpos(object, timepoint), results[0]);
+		if (1 == results.size() && 1 == transition.size())
+			return td.add_transition(transition[0], cap, modulate, forward, thread_count(threads), skip_na(na), gap_window(min_gap, max_gap),
+				code_matrix(codes));
+		return td.add_transitions(results, transition_names(result, transition), cap, modulate, forward, thread_count(threads), skip_na(na),
+			gap_window(min_gap, max_gap), code_matrix(codes));
+	} catch (exception& e) {
+		Rcerr << "Error in add_transitions(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return DataFrame::create();
+}
+
+
+//' @rdname Transitions
+// [[Rcpp::export]]
+RObject get_transitions(
+	DataFrame object,
+	CharacterVector subject = "subject",
+	const char* timepoint = "timepoint",
+	CharacterVector result = "result",
+	int cap = 0,
+	int modulate = 0,
+	bool forward = false,
+	const char* na = "propagate",
+	double min_gap = 0,
+	double max_gap = R_PosInf,
+	Nullable<IntegerMatrix> codes = R_NilValue,
+	int threads = 0)
+{
+//	cout << "——Rcpp::export——get_transitions(DataFrame, CharacterVector, const char*, CharacterVector, int, int, bool, const char*, double, double, Nullable<IntegerMatrix>, int) subject " << subject
+//		 << "; timepoint " << timepoint << "; result " << result << endl;
+	try {
+		const vector<int> results { colpos(object, result) };
+		Transitiondata td(object, colpos(object, subject), colpos(object, timepoint), results[0]);
+		if (1 == results.size())
+			return td.get_transition(cap, modulate, forward, thread_count(threads), skip_na(na), gap_window(min_gap, max_gap), code_matrix(codes));
+		return td.get_transitions(results, cap, modulate, forward, thread_count(threads), skip_na(na), gap_window(min_gap, max_gap), code_matrix(codes));
+	} catch (exception& e) {
+		Rcerr << "Error in get_transitions(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return IntegerVector();
+}
+
+
+//' @title
+//' Find Previous Test Date for Subject
+//'
+//' @name
+//' PreviousDate
+//'
+//' @description
+//' \code{get_prev_date()} identifies the previous test date for individual subjects and timepoints
+//' in a longitudinal study.
+//'
+//' \code{add_prev_date()} interpolates these previous test dates into a data frame for further analysis.
+//'
+//' @details
+//' See \code{\link{Transitions}} \emph{details}.
+//'
+//' Previous test dates further back can be found by \code{get_prev_date()} using argument \code{lag};
+//' several lags are found together in a single pass through the data.
+//'
+//' @family transitions
+//' @seealso
+//' \code{\link{data.frame}}, \code{\link{Dates}}, \code{\link[base:factor]{ordered factor}}.
+//'
+//' @param prev_date \code{character}, name to be used for a new column to record previous test dates;
+//'   default \code{"prev_date"}.
+//'
+//' @param lag \code{\link{integer}} vector, how many test dates back to look for each subject e.g.,
+//'   \code{2L} for the test before the previous one, or \code{1:3} for each of the last three; default
+//'   \code{1L}, the previous test.
+//'
+//' @inheritParams Transitions
+//'
+//' @return
+//'
+//' \item{\code{add_prev_date()}}{A \code{\link{data.frame}} based on \code{object}, with an added
+//'    column named as specified by argument \code{prev_date} of class \code{\link{Date}} containing
+//'    the values of the previous test dates.}
+//'
+//' \item{\code{get_prev_date()}}{A \code{vector} of class \code{\link{Date}}, length
+//'    \code{\link{nrow}(object)}, containing the values of the previous test dates ordered in the exact
+//'    sequence of the \code{subject} and \code{timepoint} in \code{object}; or if \code{lag} has more
+//'    than one value, a \code{\link{data.frame}} of such vectors, with columns named \code{"lag1"},
+//'    \code{"lag2"} etc.}
+//'
+//'
+//' @examples
+//'
+//' \dontshow{
+//' Blackmore <- transform(Blackmore, timepoint = as.Date("2000-01-01") + round(age * 365.25),
+//'     result = cut(exercise, breaks = seq(0, 30, 2), labels = paste0("<=", seq(0, 30, 2)[-1]),
+//'         include.lowest = TRUE, ordered_result = TRUE))
+//' }
+//'
+//'  ## Continuing example from `add_transitions()`
+//'   # subject, timepoint and result arguments all defaults and required types
+//' Blackmore |> str()
+//'
+//'   # Integer vector of the previous test dates
+//' get_prev_date(Blackmore)
+//'
+//'   # Last three test dates before each
+//' get_prev_date(Blackmore, lag = 1:3) |> head(10)
+//'
+//'   # Add column of  previous test dates to data frame
+//' add_prev_date(Blackmore) |> head(32)
+//'
+//' rm(Blackmore)
+//'
+// [[Rcpp::export]]
+DataFrame add_prev_date(
+	DataFrame object, CharacterVector subject = "subject",
+	const char* timepoint = "timepoint",
+	const char* result = "result",
+	const char* prev_date = "prev_date",
+	int threads = 0)
+{
+//	cout << "——Rcpp::export——add_prev_date(DataFrame, CharacterVector, const char*, const char*) subject "
+//	<< subject << "; timepoint " << timepoint << "; result " << result << "; prev_date " << prev_date << endl;
+	try {
+        	const NumericVector dates { Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).prev_date(thread_count(threads)) };
+        	Phase phase("wrap");
+        	object.push_back(dates, prev_date);
+ 	return object;
+	} catch (exception& e) {
+        	Rcerr << "Error in add_prev_date(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+        	Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return DataFrame::create();
+}
+
+
+//' @rdname PreviousDate
+// [[Rcpp::export]]
+RObject get_prev_date(
+	DataFrame object,
+	CharacterVector subject = "subject",
+	const char* timepoint = "timepoint",
+	const char* result = "result",
+	IntegerVector lag = IntegerVector::create(1),
+	int threads = 0)
+{
+//	cout << "——Rcpp::export——get_prev_date(DataFrame, CharacterVector, const char*, const char*) subject " << subject << "; timepoint " << timepoint << "; result " << result << endl;
+	try {
+		return Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).prev_dates(lag, thread_count(threads));
+	} catch (exception& e) {
+		Rcerr << "Error in get_prev_date(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return DateVector(0);
+}
+
+
+//' @title
+//' Find Previous Test Result for Subject
+//'
+//' @name
+//' PreviousResult
+//'
+//' @description
+//' \code{get_prev_result()} identifies the previous test result for individual subjects and timepoints
+//' in a longitudinal study.
+//'
+//' \code{add_prev_result()} interpolates these previous test results into a data frame for further analysis.
+//'
+//' @details
+//' See \code{\link{Transitions}} \emph{details}.
+//'
+//' Previous test results further back can be found by \code{get_prev_result()} using argument \code{lag};
+//' several lags are found together in a single pass through the data.
+//'
+//' @family transitions
+//' @seealso
+//' \code{\link{data.frame}}, \code{\link{Dates}}, \code{\link[base:factor]{ordered factor}}.
+//'
+//' @param prev_result \code{character}, name to be used for a new column to record previous result;
+//'   default \code{"prev_result"}.
+//'
+//' @inheritParams Transitions
+//' @inheritParams PreviousDate
+//'
+//' @return
+//'
+//' \item{\code{add_prev_result()}}{A \code{\link{data.frame}} based on \code{object}, with an added
+//'    column named as specified by argument \code{prev_result} and of type
+//'    \code{\link[base:factor]{ordered factor}} or \code{\link{integer}} depending on whether the
+//'    results are semi-quantitiative or binary.}
+//'
+//' \item{\code{get_prev_result()}}{An \code{\link[base:factor]{ordered factor}} of length
+//'    \code{\link{nrow}(object)}, containing the values of the previous test results ordered in the
+//'    exact sequence of the \code{subject} and \code{timepoint} in \code{object}; or if \code{lag} has
+//'    more than one value, a \code{\link{data.frame}} of such factors, with columns named
+//'    \code{"lag1"}, \code{"lag2"} etc.}
+//'
+//' @examples
+//'
+//' \dontshow{
+//' Blackmore <- transform(Blackmore, timepoint = as.Date("2000-01-01") + round(age * 365.25),
+//'     result = cut(exercise, breaks = seq(0, 30, 2), labels = paste0("<=", seq(0, 30, 2)[-1]),
+//'         include.lowest = TRUE, ordered_result = TRUE))
+//' }
+//'
+//'  ## Continuing example from `add_transitions()`
+//'   # subject, timepoint and result arguments all defaults and required types
+//' Blackmore |> str()
+//'
+//'   # Previous test results as ordered factor
+//' get_prev_result(Blackmore)
+//'
+//'   # Last three test results before each
+//' get_prev_result(Blackmore, lag = 1:3) |> head(10)
+//'
+//'   # Previous test result as column of data frame
+//' (Blackmore <- add_prev_result(Blackmore)) |> head(32)
+//'
+//' rm(Blackmore)
+//'
+// [[Rcpp::export]]
+DataFrame add_prev_result(
+	DataFrame object,
+	CharacterVector subject = "subject",
+	const char* timepoint = "timepoint",
+	const char* result = "result",
+	const char* prev_result = "prev_result",
+	int threads = 0
+)
+{
+//	cout << "——Rcpp::export——add_prev_result(DataFrame, CharacterVector, const char*, const char*, const char*) subject "
+//		 << subject << "; timepoint " << timepoint << "; result " << result << "; prev_result " << prev_result << endl;
+	try {
+		const IntegerVector results { prevres_intvec(object, subject, timepoint, result, thread_count(threads)) };
+		Phase phase("wrap");
+		object.push_back(results, prev_result);
+		return object;
+	} catch (exception& e) {
+		Rcerr << "Error in add_prev_result(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return DataFrame::create();
+}
+
+
+//' @rdname PreviousResult
+// [[Rcpp::export]]
+RObject get_prev_result(
+	DataFrame object,
+	CharacterVector subject = "subject",
+	const char* timepoint = "timepoint",
+	const char* result = "result",
+	IntegerVector lag = IntegerVector::create(1),
+	int threads = 0)
+{
+//	cout << "——Rcpp::export——get_prev_result(DataFrame, CharacterVector, const char*, const char*) subject " << subject << "; timepoint " << timepoint << "; result " << result << endl;
+	try {
+		return Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).prev_results(lag, thread_count(threads));
+	} catch (exception& e) {
+		Rcerr << "Error in get_prev_result(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return IntegerVector();
+}
+
+
+//' @title
+//' Find Next Test Date and Result for Subject
+//'
+//' @name
+//' NextTest
+//'
+//' @description
+//' \code{get_next_date()} and \code{get_next_result()} identify the next test date and test result
+//' for individual subjects and timepoints in a longitudinal study.
+//'
+//' @details
+//' See \code{\link{Transitions}} \emph{details}.
+//'
+//' These are the counterparts looking forward in time of \code{\link{get_prev_date}()} and
+//' \code{\link{get_prev_result}()}, and are \code{NA} for the last timepoint of each subject. To add
+//' next test dates and results to a data frame together with previous ones, or with transitions
+//' to the next result, all in the same pass through the data, use
+//' \code{\link{add_transition_columns}()}.
+//'
+//' @family transitions
+//' @seealso
+//' \code{\link{data.frame}}, \code{\link{Dates}}, \code{\link[base:factor]{ordered factor}}.
+//'
+//' @inheritParams Transitions
+//'
+//' @return
+//'
+//' \item{\code{get_next_date()}}{A \code{vector} of class \code{\link{Date}}, length
+//'    \code{\link{nrow}(object)}, containing the values of the next test dates ordered in the exact
+//'    sequence of the \code{subject} and \code{timepoint} in \code{object}.}
+//'
+//' \item{\code{get_next_result()}}{An \code{\link[base:factor]{ordered factor}} of length
+//'    \code{\link{nrow}(object)}, containing the values of the next test results ordered in the
+//'    exact sequence of the \code{subject} and \code{timepoint} in \code{object}.}
+//'
+//' @examples
+//'
+//' \dontshow{
+//' Blackmore <- transform(Blackmore, timepoint = as.Date("2000-01-01") + round(age * 365.25),
+//'     result = cut(exercise, breaks = seq(0, 30, 2), labels = paste0("<=", seq(0, 30, 2)[-1]),
+//'         include.lowest = TRUE, ordered_result = TRUE))
+//' }
+//'
+//'  ## Continuing example from `add_transitions()`
+//'   # Days until each subject's next test
+//' (get_next_date(Blackmore) - Blackmore$timepoint) |> head(10)
+//'
+//'   # Next test results as ordered factor
+//' get_next_result(Blackmore) |> head(10)
+//'
+//'   # Previous and next test dates together
+//' add_transition_columns(Blackmore, prev_result = "", transition = "", next_date = "next_date") |>
+//'     head(12)
+//'
+//' rm(Blackmore)
+//'
+// [[Rcpp::export]]
+NumericVector get_next_date(DataFrame object, CharacterVector subject = "subject", const char* timepoint = "timepoint", const char* result = "result", int threads = 0)
+{
+//	cout << "——Rcpp::export——get_next_date(DataFrame, CharacterVector, const char*, const char*, int) subject " << subject << "; timepoint " << timepoint << "; result " << result << endl;
+	try {
+		return Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).next_date(thread_count(threads));
+	} catch (exception& e) {
+		Rcerr << "Error in get_next_date(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return DateVector(0);
+}
+
+
+//' @rdname NextTest
+// [[Rcpp::export]]
+IntegerVector get_next_result(DataFrame object, CharacterVector subject = "subject", const char* timepoint = "timepoint", const char* result = "result", int threads = 0)
+{
+//	cout << "——Rcpp::export——get_next_result(DataFrame, CharacterVector, const char*, const char*, int) subject " << subject << "; timepoint " << timepoint << "; result " << result << endl;
+	try {
+		return nextres_intvec(Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)), thread_count(threads));
+	} catch (exception& e) {
+		Rcerr << "Error in get_next_result(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return IntegerVector();
+}
+
+
+//' @title
+//' Unique Values for Subject, Timepoint and Result
+//'
+//' @name
+//' uniques
+//'
+//' @description
+//' \code{uniques()} identifies unique values for subjects, timepoints and test results in
+//' longitudinal study data.
+//'
+//' @details
+//' See \code{\link{Transitions}} \emph{details}.
+//'
+//' Works for \code{subject} as an \code{\link[base:vector]{integer vector}}, a \code{\link{factor}}
+//' or a \code{\link{character}} vector, or as several columns together forming a composite key.
+//'
+//' Subjects and results, bounded by their factor levels (or by the range of integer values), are
+//' tallied in a single pass rather than sorted, as are timepoints when they are whole days over a
+//' range no longer than the number of rows; other timepoints are radix sorted. The numbers of rows
+//' for each value e.g., visits per subject, tests per date and results per level, are found in the
+//' same pass and returned if \code{counts} is \code{TRUE}.
+//'
+//' @family transitions
+//' @seealso
+//' \code{\link{data.frame}}, \code{\link{Dates}}, \code{\link[base:factor]{ordered factor}}.
+//'
+//' @param counts \code{\link{logical}}, whether to return the number of rows with each unique value;
+//'   default \code{FALSE}.
+//'
+//' @inheritParams Transitions
+//'
+//' @return
+//' A \code{\link{list}} of three elements
+//'
+//' \item{1.}{An \code{\link[base:vector]{integer vector}}, \code{\link{factor}} or
+//'   \code{\link{character}} vector of unique subject identifications, like the \code{subject} column,
+//'   or for a composite key a \code{\link{data.frame}} of the unique combinations of its columns.}
+//'
+//' \item{2.}{A \code{\link{vector}} of class \code{\link{Date}} of unique timepoints in the study.}
+//'
+//' \item{3.}{An \code{\link[base:factor]{ordered factor}} of unique values for results of the study.}
+//'
+//' If \code{counts} is \code{TRUE}, each element is instead a \code{\link{data.frame}} of these
+//' unique values, with a column \code{n} of the number of rows having each value.
+//'
+//' @examples
+//'
+//' \dontshow{
+//' Blackmore <- transform(Blackmore, timepoint = as.Date("2000-01-01") + round(age * 365.25),
+//'     result = cut(exercise, breaks = seq(0, 30, 2), labels = paste0("<=", seq(0, 30, 2)[-1]),
+//'         include.lowest = TRUE, ordered_result = TRUE))
+//' }
+//'
+//'  ## Continuing example from `add_transitions()`
+//'   # subject, timepoint and result arguments all defaults and required types
+//'   # (native subject is factor)
+//' uniques(Blackmore)
+//'   #
+//' Blackmore <- transform(Blackmore, subject = as.integer(subject))
+//'   # subject now as integer
+//' Blackmore |> str()
+//' uniques(Blackmore)
+//'
+//'   # Numbers of tests per subject, per date and per result level
+//' uniques(Blackmore, counts = TRUE) |> lapply(head)
+//'
+//' rm(Blackmore)
+//'
+// [[Rcpp::export]]
+List uniques(DataFrame object, CharacterVector subject = "subject", const char* timepoint = "timepoint", const char* result = "result", bool counts = false)
+{
+//	cout << "——Rcpp::export——uniques(DataFrame, CharacterVector, const char*, const char*, bool)\n";
+	try {
+		return Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).uniques(counts);
+	} catch (exception& e) {
+		Rcerr << "Error in uniques(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return List::create();
+}
+
+
+//' @title
+//' Prepare Longitudinal Study Data for Repeated Analysis
+//'
+//' @name
+//' PreparedTransitions
+//'
+//' @description
+//' \code{prepare_transitions()} validates the \code{subject}, \code{timepoint} and \code{result}
+//' columns of a data frame and orders its rows by subject and timepoint once, returning a handle
+//' that can be passed to any number of subsequent analyses.
+//'
+//' \code{get_transitions_prepared()}, \code{get_prev_date_prepared()},
+//' \code{get_prev_result_prepared()}, \code{get_next_date_prepared()},
+//' \code{get_next_result_prepared()} and \code{uniques_prepared()} are equivalent to
+//' \code{\link{get_transitions}()}, \code{\link{get_prev_date}()}, \code{\link{get_prev_result}()},
+//' \code{\link{get_next_date}()}, \code{\link{get_next_result}()} and \code{\link{uniques}()}, but
+//' take a handle from \code{prepare_transitions()} in place of the data frame and column names.
+//'
+//' @details
+//' See \code{\link{Transitions}} \emph{details}.
+//'
+//' Data already ordered by \code{subject} then \code{timepoint}, either ascending or exactly
+//' reversed, are detected and processed as they stand without reordering; the handle's attribute
+//' \code{"presorted"} records whether this was so, as \code{"ascending"}, \code{"descending"} or
+//' \code{"none"}.
+//'
+//' The handle refers to the columns of \code{object} as they were when it was prepared, and is
+//' valid only for the current \R session; it cannot be saved and restored with e.g.,
+//' \code{\link{saveRDS}()}.
+//'
+//' @family transitions
+//' @seealso
+//' \code{\link{data.frame}}, \code{\link{Dates}}, \code{\link[base:factor]{ordered factor}}.
+//'
+//' @param prepared a handle of class \code{"transition_index"} returned by \code{prepare_transitions()}.
+//'
+//' @inheritParams Transitions
+//' @inheritParams PreviousDate
+//' @inheritParams uniques
+//'
+//' @return
+//'
+//' \item{\code{prepare_transitions()}}{An external pointer of class \code{"transition_index"}.}
+//'
+//' \item{\code{get_transitions_prepared()}}{As \code{\link{get_transitions}()}.}
+//'
+//' \item{\code{get_prev_date_prepared()}}{As \code{\link{get_prev_date}()}.}
+//'
+//' \item{\code{get_prev_result_prepared()}}{As \code{\link{get_prev_result}()}.}
+//'
+//' \item{\code{get_next_date_prepared()}}{As \code{\link{get_next_date}()}.}
+//'
+//' \item{\code{get_next_result_prepared()}}{As \code{\link{get_next_result}()}.}
+//'
+//' \item{\code{uniques_prepared()}}{As \code{\link{uniques}()}.}
+//'
+//' @examples
+//'
+//' \dontshow{
+//' Blackmore <- transform(Blackmore, timepoint = as.Date("2000-01-01") + round(age * 365.25),
+//'     result = cut(exercise, breaks = seq(0, 30, 2), labels = paste0("<=", seq(0, 30, 2)[-1]),
+//'         include.lowest = TRUE, ordered_result = TRUE))
+//' }
+//'
+//'  ## Continuing example from `add_transitions()`
+//'   # Validate and index Blackmore once
+//' prep <- prepare_transitions(Blackmore)
+//'
+//'   # Transitions with various options, without repeating the preparation
+//' get_transitions_prepared(prep) |> table()
+//' get_transitions_prepared(prep, cap = 6) |> table()
+//' get_transitions_prepared(prep, modulate = 2) |> table()
+//'
+//'   # Previous test dates and results
+//' get_prev_date_prepared(prep) |> head(10)
+//' get_prev_result_prepared(prep) |> head(10)
+//'
+//'   # Next test results, and transitions to them
+//' get_next_result_prepared(prep) |> head(10)
+//' get_transitions_prepared(prep, forward = TRUE) |> head(10)
+//'
+//'   # Unique values
+//' uniques_prepared(prep) |> lengths()
+//'
+//' rm(Blackmore, prep)
+//'
+// [[Rcpp::export]]
+SEXP prepare_transitions(
+	DataFrame object,
+	CharacterVector subject = "subject",
+	const char* timepoint = "timepoint",
+	const char* result = "result")
+{
+//	cout << "——Rcpp::export——prepare_transitions(DataFrame, CharacterVector, const char*, const char*) subject " << subject
+//		 << "; timepoint " << timepoint << "; result " << result << endl;
+	try {
+		XPtr<Transitiondata> xp(new Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)), true);
+		xp.attr("class") = "transition_index";
+		xp.attr("presorted") = xp->presorted();
+		return xp;
+	} catch (exception& e) {
+		Rcerr << "Error in prepare_transitions(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return R_NilValue;
+}
+
+
+//' @rdname PreparedTransitions
+// [[Rcpp::export]]
+IntegerVector get_transitions_prepared(SEXP prepared, int cap = 0, int modulate = 0, bool forward = false, const char* na = "propagate",
+	double min_gap = 0, double max_gap = R_PosInf, Nullable<IntegerMatrix> codes = R_NilValue, int threads = 0)
+{
+//	cout << "——Rcpp::export——get_transitions_prepared(SEXP, int, int, bool, const char*, double, double, Nullable<IntegerMatrix>, int) cap " << cap << "; modulate " << modulate << endl;
+	try {
+		return wrap(prepared_data(prepared).get_transition(cap, modulate, forward, thread_count(threads), skip_na(na), gap_window(min_gap, max_gap),
+			code_matrix(codes)));
+	} catch (exception& e) {
+		Rcerr << "Error in get_transitions_prepared(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return IntegerVector();
+}
+
+
+//' @rdname PreparedTransitions
+// [[Rcpp::export]]
+RObject get_prev_date_prepared(SEXP prepared, IntegerVector lag = IntegerVector::create(1), int threads = 0)
+{
+//	cout << "——Rcpp::export——get_prev_date_prepared(SEXP, IntegerVector, int)\n";
+	try {
+		return prepared_data(prepared).prev_dates(lag, thread_count(threads));
+	} catch (exception& e) {
+		Rcerr << "Error in get_prev_date_prepared(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return DateVector(0);
+}
+
+
+//' @rdname PreparedTransitions
+// [[Rcpp::export]]
+RObject get_prev_result_prepared(SEXP prepared, IntegerVector lag = IntegerVector::create(1), int threads = 0)
+{
+//	cout << "——Rcpp::export——get_prev_result_prepared(SEXP, IntegerVector, int)\n";
+	try {
+		return prepared_data(prepared).prev_results(lag, thread_count(threads));
+	} catch (exception& e) {
+		Rcerr << "Error in get_prev_result_prepared(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return IntegerVector();
+}
+
+
+//' @rdname PreparedTransitions
+// [[Rcpp::export]]
+NumericVector get_next_date_prepared(SEXP prepared, int threads = 0)
+{
+//	cout << "——Rcpp::export——get_next_date_prepared(SEXP, int)\n";
+	try {
+		return prepared_data(prepared).next_date(thread_count(threads));
+	} catch (exception& e) {
+		Rcerr << "Error in get_next_date_prepared(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return DateVector(0);
+}
+
+
+//' @rdname PreparedTransitions
+// [[Rcpp::export]]
+IntegerVector get_next_result_prepared(SEXP prepared, int threads = 0)
+{
+//	cout << "——Rcpp::export——get_next_result_prepared(SEXP, int)\n";
+	try {
+		return nextres_intvec(prepared_data(prepared), thread_count(threads));
+	} catch (exception& e) {
+		Rcerr << "Error in get_next_result_prepared(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return IntegerVector();
+}
+
+
+//' @rdname PreparedTransitions
+// [[Rcpp::export]]
+List uniques_prepared(SEXP prepared, bool counts = false)
+{
+//	cout << "——Rcpp::export——uniques_prepared(SEXP, bool)\n";
+	try {
+		return prepared_data(prepared).uniques(counts);
+	} catch (exception& e) {
+		Rcerr << "Error in uniques_prepared(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return List::create();
+}
+
+
+//' @title
+//' Add Previous Dates, Previous Results and Transitions Together
+//'
+//' @name
+//' TransitionColumns
 //'
 //' @description
-//' \code{get_transitions()} identifies temporal transitions in test results for individual
-//' subjects in a longitudinal study.
+//' \code{add_transition_columns()} interpolates any combination of previous test dates, previous
+//' test results, test result transitions, intervals since the previous test, and next test dates and
+//' results into a data frame, validating and ordering the data only once.
 //'
-//' \code{add_transitions()} interpolates these transitions into a data frame for further analysis.
+//' @details
+//' See \code{\link{Transitions}} \emph{details}.
+//'
+//' The added columns are identical to those from \code{\link{add_prev_date}()},
+//' \code{\link{add_prev_result}()} and \code{\link{add_transitions}()}, but are all found in the
+//' same pass through the data and added to \code{object} at once. Any column can be omitted by
+//' giving it the empty name \code{""}.
+//'
+//' Next test dates and results are as from \code{\link{get_next_date}()} and
+//' \code{\link{get_next_result}()}. If \code{forward} is \code{TRUE}, transitions and intervals run
+//' from each timepoint to the subject's next, rather than from the previous one.
+//'
+//' With \code{min_gap} or \code{max_gap} (see \code{\link{Transitions}}), previous and next
+//' timepoints outside that window are treated as absent, so that all columns derived from them are
+//' \code{NA}.
+//'
+//' @family transitions
+//' @seealso
+//' \code{\link{data.frame}}, \code{\link{Dates}}, \code{\link[base:factor]{ordered factor}}.
+//'
+//' @param interval \code{character}, name to be used for a new column (of type \code{\link{numeric}})
+//'   to record the time since the previous test, in days for \code{\link{Dates}} or seconds for
+//'   \code{\link{POSIXct}}; default \code{""}, omitting the column.
+//'
+//' @param next_date \code{character}, name to be used for a new column to record next test dates;
+//'   default \code{""}, omitting the column.
+//'
+//' @param next_result \code{character}, name to be used for a new column to record next test
+//'   results; default \code{""}, omitting the column.
+//'
+//' @param days \code{character}, name to be used for a new column (of type \code{\link{integer}})
+//'   to record the whole number of days since the previous test, or if \code{forward}, to the next;
+//'   default \code{""}, omitting the column.
+//'
+//' @inheritParams Transitions
+//' @inheritParams PreviousDate
+//' @inheritParams PreviousResult
+//'
+//' @return
+//' A \code{\link{data.frame}} based on \code{object}, with added columns named as specified by
+//' arguments \code{prev_date}, \code{prev_result}, \code{transition}, \code{interval},
+//' \code{next_date}, \code{next_result} and \code{days}, in that order, omitting any with the empty
+//' name \code{""}.
+//'
+//' @examples
+//'
+//' \dontshow{
+//' Blackmore <- transform(Blackmore, timepoint = as.Date("2000-01-01") + round(age * 365.25),
+//'     result = cut(exercise, breaks = seq(0, 30, 2), labels = paste0("<=", seq(0, 30, 2)[-1]),
+//'         include.lowest = TRUE, ordered_result = TRUE))
+//' }
+//'
+//'  ## Continuing example from `add_transitions()`
+//'   # Previous test dates and results, and transitions
+//' add_transition_columns(Blackmore) |> head(12)
+//'
+//'   # Transitions and days since previous test only
+//' add_transition_columns(Blackmore, prev_date = "", prev_result = "", interval = "interval") |>
+//'     head(12)
+//'
+//'   # Transitions only between tests at most two years apart, with whole days between them
+//' add_transition_columns(Blackmore, prev_date = "", prev_result = "", days = "days",
+//'     max_gap = 730) |> head(12)
+//'
+//'   # Next test results, with transitions and days to them
+//' add_transition_columns(Blackmore, prev_date = "", prev_result = "", interval = "interval",
+//'     next_result = "next_result", forward = TRUE) |> head(12)
+//'
+//' rm(Blackmore)
+//'
+// [[Rcpp::export]]
+DataFrame add_transition_columns(
+	DataFrame object,
+	CharacterVector subject = "subject",
+	const char* timepoint = "timepoint",
+	const char* result = "result",
+	const char* prev_date = "prev_date",
+	const char* prev_result = "prev_result",
+	const char* transition = "transition",
+	const char* interval = "",
+	const char* next_date = "",
+	const char* next_result = "",
+	const char* days = "",
+	int cap = 0,
+	int modulate = 0,
+	bool forward = false,
+	const char* na = "propagate",
+	double min_gap = 0,
+	double max_gap = R_PosInf,
+	int threads = 0)
+{
+//	cout << "——Rcpp::export——add_transition_columns(DataFrame, CharacterVector, const char*, const char*, const char*, const char*, const char*, const char*, const char*, int, int, bool, const char*, double, double, int) subject "
+//		 << subject << "; timepoint " << timepoint << "; result " << result << endl;
+	try {
+		return Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result))
+			.add_columns(prev_date, prev_result, transition, interval, next_date, next_result, days, cap, modulate, forward, thread_count(threads),
+				skip_na(na), gap_window(min_gap, max_gap));
+	} catch (exception& e) {
+		Rcerr << "Error in add_transition_columns(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return DataFrame::create();
+}
+
+
+//' @title
+//' Update Transitions with Newly Appended Test Results
+//'
+//' @name
+//' IncrementalTransitions
+//'
+//' @description
+//' \code{transition_state()} records the latest timepoint and test result of each subject in
+//' longitudinal study data prepared by \code{\link{prepare_transitions}()}.
+//'
+//' \code{update_transitions()} finds previous test dates, previous test results and transitions for
+//' a further round of test results using only that record, and brings the record up to date.
 //'
 //' @details
-//' The data can be presented in any order e.g., ordered by \code{subject}, by \code{timepoint},
-//' forwards or backwards in time, or entirely at random, and may have unbalanced designs with different
-//' time points or numbers of test results per subject. However, the \emph{user} is responsible for
-//' ensuring the data contain unique combinations of \code{subject}, \code{timepoint} and \code{result};
-//' if not, outputs will be undefined.
+//' See \code{\link{Transitions}} \emph{details}.
 //'
-//' Time points should be formatted as \code{\link{Dates}} and included in data frame \code{object} in
-//' the column named as specified by argument \code{timepoint} (see \emph{Note}).
+//' A state returned by \code{transition_state()} or \code{update_transitions()} is an ordinary
+//' data frame that may be saved and restored between \R sessions. Applying \code{update_transitions()}
+//' to each new round of results in turn gives the same values as \code{\link{add_transition_columns}()}
+//' applied to the whole study, with time proportional to the size of each round rather than that of the
+//' study.
 //'
-//' Test results should either be semi-quantitiative, formatted as an
-//' \code{\link[base:ordered]{ordered factor}} (see \emph{Note}), or binary data formatted as an
-//' \code{\link{integer}} (or \code{\link{numeric}}) vector with values of either \code{1} or \code{0},
-//' and included in \code{object} in the data frame column specified by argument \code{result}.
+//' New test results for a subject that do not all follow its latest timepoint in \code{state} can only
+//' be placed using the subject's full history, which must then be supplied as argument \code{history};
+//' only the subjects so affected are reworked. Values are returned just for the new rows: those of
+//' existing rows following any interposed timepoints are not revised.
 //'
-//' Temporal transitions in the test \code{results} for each \code{subject} within the \code{object}
-//' \code{\link{data.frame}} are characterised using methods governed by options \code{cap} and
-//' \code{modulate}. If these two parameters are both zero (their defaults), a simple arithmetic
-//' difference between the levels of the present and previous result is calculated. Otherwise, if
-//' the value of \code{modulate} is a positive, non-zero integer, the arithmetic difference is
-//' subjected to integer division by that value. Finally, if \code{cap} is a positive, non-zero
-//' integer, the (possibly modulated) absolute arithmetic difference is capped at that value.
+//' Subjects and results must be coded consistently, i.e., factors must have identical levels in
+//' \code{state}, \code{object} and \code{history}; \code{\link{character}} subjects should first
+//' be converted to a \code{\link{factor}} with the same levels throughout. Argument \code{subject}
+//' must name a single column; combinations of several may be coded as a single factor by
+//' \code{\link{interaction}()}.
 //'
 //' @family transitions
 //' @seealso
-//' \code{\link{data.frame}}, \code{\link{Dates}}, and \code{\link[base:factor]{ordered factor}}.
+//' \code{\link{data.frame}}, \code{\link{Dates}}, \code{\link[base:factor]{ordered factor}}.
 //'
-//' @param object a \code{\link{data.frame}} (or object coercible by \code{\link{as.data.frame}()} to
-//'   a data frame) containing the data to be analysed.
+//' @param state a \code{\link{data.frame}} returned by \code{transition_state()}, or as element
+//'   \code{state} by \code{update_transitions()}.
 //'
-//' @param subject \code{\link{character}}, name of the column (of type \code{\link{integer}} or
-//'   \code{\link{factor}}) identifying individual study subjects; default \code{"subject"}.
+//' @param object a \code{\link{data.frame}} of new test results, with the same columns \code{subject},
+//'   \code{timepoint} and \code{result} as the study data.
 //'
-//' @param timepoint \code{character}, name of the column recording time points (as \code{\link{Dates}})
-//'   of testing of subjects; default \code{"timepoint"}.
+//' @param history \code{NULL} (the default) or a handle from \code{\link{prepare_transitions}()} for
+//'   the study data preceding \code{object}, required only if new timepoints for a subject do not all
+//'   follow its latest timepoint in \code{state}.
 //'
-//' @param result \code{character}, name of the column (of type \code{\link[base:factor]{ordered factor}},
-//'   or binary, see \emph{Details}) recording test results; default \code{"result"}.
+//' @inheritParams Transitions
+//' @inheritParams PreviousDate
+//' @inheritParams PreviousResult
+//' @inheritParams PreparedTransitions
 //'
-//' @param transition \code{character}, name to be used for a new column (of type
-//'   \code{\link{integer}}) to record transitions; default \code{"transition"}.
+//' @return
 //'
-//' @param cap \code{\link{integer}}, required for calculating transitions; default \code{0L}.
+//' \item{\code{transition_state()}}{A \code{\link{data.frame}} with columns named as \code{subject},
+//'   \code{timepoint} and \code{result}, and one row for each subject with its latest timepoint and
+//'   test result.}
 //'
-//' @param modulate \code{\link{integer}}, required for calculating transitions; default \code{0L}.
+//' \item{\code{update_transitions()}}{A \code{\link{list}} of two elements: \code{data}, a
+//'   \code{\link{data.frame}} based on \code{object} with added columns named as specified by arguments
+//'   \code{prev_date}, \code{prev_result} and \code{transition}; and \code{state}, the updated state.}
+//'
+//' @examples
+//'
+//' \dontshow{
+//' Blackmore <- transform(Blackmore, timepoint = as.Date("2000-01-01") + round(age * 365.25),
+//'     result = cut(exercise, breaks = seq(0, 30, 2), labels = paste0("<=", seq(0, 30, 2)[-1]),
+//'         include.lowest = TRUE, ordered_result = TRUE))
+//' }
+//'
+//'  ## Continuing example from `add_transitions()`
+//'   # Split Blackmore into earlier and later test results
+//' early <- subset(Blackmore, age < 12)
+//' late <- subset(Blackmore, age >= 12)
+//'
+//'   # Latest timepoint and result for each subject in earlier data
+//' (state <- transition_state(prepare_transitions(early))) |> head()
+//'
+//'   # Transitions for later test results
+//' upd <- update_transitions(state, late)
+//' upd$data |> head(12)
+//'
+//'   # Same as from the whole study
+//' all.equal(
+//'     upd$data$transition,
+//'     subset(add_transition_columns(Blackmore), age >= 12)$transition
+//' )
+//'
+//' rm(Blackmore, early, late, state, upd)
+//'
+// [[Rcpp::export]]
+DataFrame transition_state(SEXP prepared)
+{
+//	cout << "——Rcpp::export——transition_state(SEXP)\n";
+	try {
+		return prepared_data(prepared).state();
+	} catch (exception& e) {
+		Rcerr << "Error in transition_state(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return DataFrame::create();
+}
+
+
+//' @rdname IncrementalTransitions
+// [[Rcpp::export]]
+List update_transitions(
+	DataFrame state,
+	DataFrame object,
+	const char* subject = "subject",
+	const char* timepoint = "timepoint",
+	const char* result = "result",
+	const char* prev_date = "prev_date",
+	const char* prev_result = "prev_result",
+	const char* transition = "transition",
+	int cap = 0,
+	int modulate = 0,
+	SEXP history = R_NilValue)
+{
+//	cout << "——Rcpp::export——update_transitions(DataFrame, DataFrame, const char*, const char*, const char*, const char*, const char*, const char*, int, int, SEXP) subject "
+//		 << subject << "; timepoint " << timepoint << "; result " << result << endl;
+	try {
+		const Transitiondata st(state, colpos(state, subject), colpos(state, timepoint), colpos(state, result));
+		return Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result))
+			.update(st, Rf_isNull(history) ? nullptr : &prepared_data(history), prev_date, prev_result, transition, cap, modulate);
+	} catch (exception& e) {
+		Rcerr << "Error in update_transitions(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return List::create();
+}
+
+
+//' @title
+//' Tabulate Transitions Between Test Result Levels
+//'
+//' @name
+//' TransitionMatrix
+//'
+//' @description
+//' \code{transition_matrix()} counts transitions from each level of the previous test result to each
+//' level of the test result for individual subjects in a longitudinal study, optionally separately for
+//' each subject or for each calendar year or month.
+//'
+//' @details
+//' See \code{\link{Transitions}} \emph{details}.
+//'
+//' The counts are the same as from \code{\link{table}(\link{get_prev_result}(object), object$result)},
+//' but are accumulated as the data are swept, without creating vectors of previous results. Test results
+//' for which either the result or the previous result is missing are not counted.
+//'
+//' Binary results have levels \code{"0"} and \code{"1"}. Calendar periods are those of the later of the
+//' two test dates of each transition, and for \code{\link{POSIXct}} timepoints, are taken in the time zone
+//' of the column.
+//'
+//' @family transitions
+//' @seealso
+//' \code{\link{data.frame}}, \code{\link{Dates}}, \code{\link[base:factor]{ordered factor}},
+//' \code{\link{table}}.
+//'
+//' @param by \code{character}, either \code{"none"} (the default), or one of \code{"subject"},
+//'   \code{"year"} or \code{"month"} to count transitions separately for each subject or calendar
+//'   period.
+//'
+//' @inheritParams Transitions
 //'
 //' @return
+//' An \code{\link{integer}} \code{\link{matrix}} of transition counts, with rows for the levels of
+//' previous results (\code{from}) and columns for those of results (\code{to}), or for \code{by} other
+//' than \code{"none"}, a three dimensional \code{\link{array}} of such matrices, one for each subject,
+//' year or month.
+//'
+//' @examples
+//'
+//' \dontshow{
+//' Blackmore <- transform(Blackmore, timepoint = as.Date("2000-01-01") + round(age * 365.25),
+//'     result = cut(exercise, breaks = seq(0, 30, 2), labels = paste0("<=", seq(0, 30, 2)[-1]),
+//'         include.lowest = TRUE, ordered_result = TRUE))
+//' }
+//'
+//'  ## Continuing example from `add_transitions()`
+//'   # Transitions between levels of exercise
+//' transition_matrix(Blackmore)[1:5, 1:5]
+//'
+//'   # Transitions of the first subject
+//' transition_matrix(Blackmore, by = "subject")[1:5, 1:5, 1]
+//'
+//'   # Transitions by year
+//' transition_matrix(Blackmore, by = "year") |> apply(3, sum)
+//'
+//' rm(Blackmore)
+//'
+// [[Rcpp::export]]
+IntegerVector transition_matrix(
+	DataFrame object,
+	CharacterVector subject = "subject",
+	const char* timepoint = "timepoint",
+	const char* result = "result",
+	const char* by = "none",
+	int threads = 0)
+{
+//	cout << "——Rcpp::export——transition_matrix(DataFrame, CharacterVector, const char*, const char*, const char*, int) subject " << subject
+//		 << "; timepoint " << timepoint << "; result " << result << "; by " << by << endl;
+	try {
+		return Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).transition_matrix(by, thread_count(threads));
+	} catch (exception& e) {
+		Rcerr << "Error in transition_matrix(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return IntegerVector();
+}
+
+
+//' @title
+//' Summarise Test Results and Episodes of Each Subject
+//'
+//' @name
+//' SubjectSummary
+//'
+//' @description
+//' \code{subject_summary()} summarises the test results of each subject in a longitudinal study in a
+//' single row: the number of tests, first and last timepoints, numbers of transitions up and down,
+//' runs of the same result, and times to the first positive result and to reversion from it.
 //'
-//' \item{\code{add_transitions()}}{A \code{\link{data.frame}} based on \code{object}, with an added
-//'    column of type \code{\link{integer}} containing the values of the test result transitions.}
+//' \code{transition_episodes()} lists the episodes of each subject, runs of consecutive tests with the
+//' same result, one row per episode.
 //'
-//' \item{\code{get_transitions()}}{An \code{\link[base:vector]{integer vector}} of length
-//'    \code{\link{nrow}(object)}, containing the values of the test result transitions ordered in the exact
-//'    sequence of the \code{subject} and \code{timepoint} in \code{object}.}
+//' @details
+//' See \code{\link{Transitions}} \emph{details}.
 //'
-//' @note
-//' Time points represented by \code{\link{integer}} or \code{\link{numeric}} values can be converted
-//'   to R \code{Dates} conveniently using \code{\link{as.Date}()}. If only \emph{year} information is
-//'   available, arbitrary values could be used consistently for month and day e.g., 1st of January of
-//'   each year; likewise, the first day of each month could be used arbitrarily, if only the
-//'   \emph{year} and \emph{month} were known. See vignette 
-//'   \href{../doc/convertDate.pdf}{Converting numeric values to class \code{"Date"}} for examples.
+//' Both are computed in a single pass through the data ordered by subject and timepoint, sharing
+//' subjects among threads, without creating vectors of previous results or transitions.
 //'
-//' Quantitive results available as \code{\link{numeric}} data can be converted to a semi-quantitative
-//'   \code{\link[base:factor]{ordered factor}} conveniently using \code{\link{cut}()} (see \emph{examples}).
+//' Transitions up and down are counted as in \code{\link{transition_matrix}()}, from the result at the
+//' previous timepoint of the subject, and are not counted if either result is missing. Missing results
+//' are otherwise passed over: they neither end an episode nor count towards its length.
 //'
-//' @examples
+//' A result is positive if at or above level \code{positive}; by default, any level above the lowest,
+//' i.e. \code{1} for binary results. Reversion is the first result below that level after the first
+//' positive result. Times are differences of timepoints, in days for \code{\link{Dates}}, seconds for
+//' \code{\link{POSIXct}}, or otherwise the units of the timepoints.
 //'
-//'   # Inspect Blackmore data frame using {base} str()
-//' Blackmore |> str()
+//' @family transitions
+//' @seealso
+//' \code{\link{data.frame}}, \code{\link{Dates}}, \code{\link[base:factor]{ordered factor}},
+//' \code{\link{rle}}.
 //'
-//'   # {base} hist() gives insights into the "exercise" column,
-//'   #   useful for choosing `breaks` and `labels` in cut() below
-//' hist(Blackmore$exercise, include.lowest = TRUE, plot = FALSE)[1:2]
+//' @param positive \code{character}, the lowest level of \code{result} counted as positive; default
+//'   \code{""}, the level next above the lowest.
 //'
-//'   # Tweak Blackmore data frame by converting "age" to dates for the argument
-//'   #   timepoint (using an arbitrary "origin" of 1-Jan-2000), and converting
-//'   #   "exercise" to an ordered factor "result" with {base} cut()
-//' Blackmore <- transform(Blackmore,
-//'     timepoint = as.Date("2000-01-01") + round(age * 365.25),
-//'     result = cut(
-//'         exercise,
-//'         breaks = seq(0, 30, 2),
-//'         labels = paste0("<=", seq(0, 30, 2)[-1]),
-//'         include.lowest = TRUE,
-//'         ordered_result = TRUE
-//'     )
-//' )
+//' @inheritParams Transitions
 //'
-//'   # subject, timepoint and result arguments now defaults and required types
-//' Blackmore |> str()
+//' @return
+//' \item{\code{subject_summary()}}{A \code{\link{data.frame}} with one row for each subject, in order,
+//'    comprising the subject column or columns, then \code{tests}, the number of tests; \code{first}
+//'    and \code{last}, timepoints of the first and last tests; \code{ups} and \code{downs}, numbers
+//'    of transitions to a higher or lower result; \code{episodes}, the number of runs of the same
+//'    result; \code{longest}, the number of tests in the longest such run; \code{to_positive}, time
+//'    from the first test to the first positive result; and \code{to_reversion}, time from the first
+//'    positive result to the next result that is not; either time \code{NA} if there is none.}
 //'
-//'   # Integer vector of test result transitions (defaults: cap = modulate = 0)
-//' get_transitions(Blackmore)
+//' \item{\code{transition_episodes()}}{A \code{\link{data.frame}} with one row for each episode,
+//'    ordered by subject and timepoint, comprising the subject column or columns, the result column
+//'    and columns \code{start} and \code{end}, the timepoints of the first and last tests of the
+//'    episode, and \code{tests}, their number.}
 //'
-//'   # Tabulate values of transitions
-//' get_transitions(Blackmore) |> table()
+//' @examples
 //'
-//'   # Effect of cap argument
-//' get_transitions(Blackmore, cap = 6) |> table()
+//' \dontshow{
+//' Blackmore <- transform(Blackmore, timepoint = as.Date("2000-01-01") + round(age * 365.25),
+//'     result = cut(exercise, breaks = seq(0, 30, 2), labels = paste0("<=", seq(0, 30, 2)[-1]),
+//'         include.lowest = TRUE, ordered_result = TRUE))
+//' }
 //'
-//'   # Effect of modulate argument
-//' get_transitions(Blackmore, modulate = 2) |> table()
+//'  ## Continuing example from `add_transitions()`
+//'   # Summary of each subject
+//' subject_summary(Blackmore) |> head()
 //'
-//'   # Add column of test result transitions to data frame
-//' add_transitions(Blackmore) |> head(22)
+//'   # Time to exercising more than 4 hours a week
+//' subject_summary(Blackmore, positive = "<=6") |> head()
 //'
-//'   # Showing transitions as either positive (1) or negative (-1)
-//'   #   (defaults to modulate = 0)
-//' add_transitions(Blackmore, cap = 1) |> head(14)
+//'   # Episodes of each subject
+//' transition_episodes(Blackmore) |> head(10)
 //'
 //' rm(Blackmore)
 //'
 // [[Rcpp::export]]
-DataFrame add_transitions(
+DataFrame subject_summary(
 	DataFrame object,
-	const char* subject = "subject",
+	CharacterVector subject = "subject",
 	const char* timepoint = "timepoint",
 	const char* result = "result",
-	const char* transition = "transition",
-	int cap = 0,
-	int modulate = 0)
+	const char* positive = "",
+	int threads = 0)
 {
-//	cout << "——Rcpp::export——add_transitions(DataFrame, const char*, const char*, const char*, const char*, int) subject " << subject
-//		 << "; timepoint " << timepoint << "; result " << result << "; transition " << transition << endl;
+//	cout << "——Rcpp::export——subject_summary(DataFrame, CharacterVector, const char*, const char*, const char*, int) subject " << subject
+//		 << "; timepoint " << timepoint << "; result " << result << "; positive " << positive << endl;
 	try {
-		return Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).add_transition(transition, cap, modulate);
+		return Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).subject_summary(positive, thread_count(threads));
 	} catch (exception& e) {
-		Rcerr << "Error in add_transitions(): " << e.what() << '\n';
+		Rcerr << "Error in subject_summary(): " << e.what() << '\n';
 	} catch (std::invalid_argument& iva) {
 		Rcerr << "Error invalid argument: " << iva.what() << '\n';
 	}
@@ -422,155 +3687,299 @@ DataFrame add_transitions(
 }
 
 
-//' @rdname Transitions
+//' @rdname SubjectSummary
 // [[Rcpp::export]]
-IntegerVector get_transitions(
+DataFrame transition_episodes(
 	DataFrame object,
-	const char* subject = "subject",
+	CharacterVector subject = "subject",
 	const char* timepoint = "timepoint",
 	const char* result = "result",
-	int cap = 0,
-	int modulate = 0)
+	int threads = 0)
 {
-//	cout << "——Rcpp::export——get_transitions(DataFrame, const char*, const char*, const char*, int) subject " << subject
+//	cout << "——Rcpp::export——transition_episodes(DataFrame, CharacterVector, const char*, const char*, int) subject " << subject
 //		 << "; timepoint " << timepoint << "; result " << result << endl;
 	try {
-		return wrap(Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).get_transition(cap, modulate));
+		return Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).episodes(thread_count(threads));
 	} catch (exception& e) {
-		Rcerr << "Error in get_transitions(): " << e.what() << '\n';
+		Rcerr << "Error in transition_episodes(): " << e.what() << '\n';
 	} catch (std::invalid_argument& iva) {
 		Rcerr << "Error invalid argument: " << iva.what() << '\n';
 	}
-	return IntegerVector();
+	return DataFrame::create();
 }
 
 
 //' @title
-//' Find Previous Test Date for Subject
+//' Generate Synthetic Longitudinal Study Data
 //'
 //' @name
-//' PreviousDate
+//' SyntheticStudy
 //'
 //' @description
-//' \code{get_prev_date()} identifies the previous test date for individual subjects and timepoints
-//' in a longitudinal study.
-//'
-//' \code{add_prev_date()} interpolates these previous test dates into a data frame for further analysis.
+//' \code{synthetic_study()} generates test results for subjects at repeated timepoints, in the form
+//' required by \code{\link{add_transitions}()} and related functions, e.g. for benchmarking them on
+//' studies of any size.
 //'
 //' @details
-//' See \code{\link{Transitions}} \emph{details}.
+//' Each subject is tested at \code{visits} timepoints or, if \code{unbalanced} is \code{TRUE}, at a
+//' number of timepoints drawn uniformly between one and \code{2 * visits - 1}. The first timepoint
+//' falls at random in the ten years from 1st January 2000, and each subsequent one from one day to six
+//' months after the last. The first result is drawn uniformly from \code{levels}, and each
+//' subsequent one is the same, or one level higher or lower, with equal probability.
+//'
+//' Rows are ordered by \code{subject} then \code{timepoint} if \code{order} is \code{"sorted"}, the
+//' exact reverse if \code{"reversed"}, or at random if \code{"random"}.
+//'
+//' Random numbers are drawn using \R's generator, so results can be reproduced using
+//' \code{\link{set.seed}()}.
 //'
 //' @family transitions
 //' @seealso
-//' \code{\link{data.frame}}, \code{\link{Dates}}, \code{\link[base:factor]{ordered factor}}.
+//' \code{\link{data.frame}}, \code{\link{Dates}}, \code{\link[base:factor]{ordered factor}},
+//' \code{\link{set.seed}}.
 //'
-//' @param prev_date \code{character}, name to be used for a new column to record previous test dates;
-//'   default \code{"prev_date"}.
+//' @param subjects \code{\link{integer}}, number of subjects; default \code{1000L}.
 //'
-//' @inheritParams Transitions
+//' @param visits \code{integer}, number of timepoints per subject, or the mean number if
+//'   \code{unbalanced}; default \code{10L}.
 //'
-//' @return
+//' @param levels \code{integer}, number of levels of the test result; default \code{5L}.
 //'
-//' \item{\code{add_prev_date()}}{A \code{\link{data.frame}} based on \code{object}, with an added
-//'    column named as specified by argument \code{prev_date} of class \code{\link{Date}} containing
-//'    the values of the previous test dates.}
+//' @param order \code{\link{character}}, order of rows, one of \code{"sorted"},
+//'   \code{"reversed"} or \code{"random"}; default \code{"random"}.
 //'
-//' \item{\code{get_prev_date()}}{A \code{vector} of class \code{\link{Date}}, length
-//'    \code{\link{nrow}(object)}, containing the values of the previous test dates ordered in the exact
-//'    sequence of the \code{subject} and \code{timepoint} in \code{object}.}
+//' @param unbalanced \code{\link{logical}}, whether subjects have different numbers of timepoints;
+//'   default \code{FALSE}.
 //'
+//' @return
+//' A \code{\link{data.frame}} with columns \code{subject} of type \code{\link{integer}},
+//' \code{timepoint} of class \code{\link{Date}} and \code{result}, an
+//' \code{\link[base:factor]{ordered factor}} with levels \code{"1"}, \code{"2"} etc.
 //'
 //' @examples
 //'
-//' \dontshow{
-//' Blackmore <- transform(Blackmore, timepoint = as.Date("2000-01-01") + round(age * 365.25),
-//'     result = cut(exercise, breaks = seq(0, 30, 2), labels = paste0("<=", seq(0, 30, 2)[-1]),
-//'         include.lowest = TRUE, ordered_result = TRUE))
-//' }
-//'
-//'  ## Continuing example from `add_transitions()`
-//'   # subject, timepoint and result arguments all defaults and required types
-//' Blackmore |> str()
-//'
-//'   # Integer vector of the previous test dates
-//' get_prev_date(Blackmore)
+//' set.seed(1)
+//' study <- synthetic_study(subjects = 100, visits = 5, unbalanced = TRUE)
+//' study |> str()
 //'
-//'   # Add column of  previous test dates to data frame
-//' add_prev_date(Blackmore) |> head(32)
+//'   # Ready for use with default arguments
+//' add_transitions(study) |> head(10)
 //'
-//' rm(Blackmore)
+//' rm(study)
 //'
 // [[Rcpp::export]]
-DataFrame add_prev_date(
-	DataFrame object, const char* subject = "subject",
+DataFrame synthetic_study(
+	int subjects = 1000,
+	int visits = 10,
+	int levels = 5,
+	const char* order = "random",
+	bool unbalanced = false)
+{
+//	cout << "——Rcpp::export——synthetic_study(int, int, int, const char*, bool) subjects " << subjects << "; visits " << visits
+//		 << "; levels " << levels << "; order " << order << endl;
+	try {
+		return synthetic(subjects, visits, levels, order, unbalanced);
+	} catch (exception& e) {
+		Rcerr << "Error in synthetic_study(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	}
+	return DataFrame::create();
+}
+
+
+// Reference implementation, for validation only
+// [[Rcpp::export(.reference_transitions)]]
+DataFrame reference_transitions(
+	DataFrame object,
+	const char* subject = "subject",
 	const char* timepoint = "timepoint",
 	const char* result = "result",
-	const char* prev_date = "prev_date")
+	int cap = 0,
+	int modulate = 0,
+	int lag = 1)
 {
-//	cout << "——Rcpp::export——add_prev_date(DataFrame, const char*, const char*, const char*) subject "
-//	<< subject << "; timepoint " << timepoint << "; result " << result << "; prev_date " << prev_date << endl;
+//	cout << "——Rcpp::export——reference_transitions(DataFrame, const char*, const char*, const char*, int, int, int) subject " << subject
+//		 << "; timepoint " << timepoint << "; result " << result << endl;
 	try {
-        	object.push_back(DateVector(wrap(Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).prev_date())), prev_date);
- 	return object;
+		return Reference(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).reference(cap, modulate, lag);
 	} catch (exception& e) {
-        	Rcerr << "Error in add_prev_date(): " << e.what() << '\n';
+		Rcerr << "Error in reference_transitions(): " << e.what() << '\n';
 	} catch (std::invalid_argument& iva) {
-        	Rcerr << "Error invalid argument: " << iva.what() << '\n';
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
 	}
 	return DataFrame::create();
 }
 
 
-//' @rdname PreviousDate
+//' @title
+//' Profile Time and Memory Spent in Each Phase of Analysis
+//'
+//' @name
+//' TransitionProfile
+//'
+//' @description
+//' \code{transition_profile()} reports the wall time and memory allocated in each phase of the
+//' analyses run since it was last called, while option \code{Transition.profile} is \code{TRUE}.
+//'
+//' @details
+//' Setting \code{\link{options}(Transition.profile = TRUE)} records the following phases of every
+//' subsequent call to functions of this package, at a cost of reading the clock a few times per
+//' call:
+//'
+//' \describe{
+//'   \item{\code{"validate"}}{checking the types of the \code{subject}, \code{timepoint} and
+//'     \code{result} columns, and any conversions of their types.}
+//'   \item{\code{"index"}}{checking whether rows are already ordered by subject and timepoint, and
+//'     if not, ordering them.}
+//'   \item{\code{"sweep"}}{the passes through the ordered rows, on all \code{threads}.}
+//'   \item{\code{"uniques"}}{finding unique values, by \code{\link{uniques}()}.}
+//'   \item{\code{"wrap"}}{allocating the \R vectors returned, and adding them to data frames.}
+//' }
+//'
+//' Times of phases running within others e.g., \code{"wrap"} within \code{"uniques"}, are also
+//' included in the times of those others. Memory is that allocated for the data or index, not
+//' including that used by \R for attributes or by the operating system for threads.
+//'
+//' @family transitions
+//' @seealso
+//' \code{\link{options}}, \code{\link{system.time}}.
+//'
+//' @param reset \code{\link{logical}}, whether to clear the phases recorded so far; default
+//'   \code{TRUE}.
+//'
+//' @return
+//' A \code{\link{data.frame}} with a row for each phase recorded, in order of first occurrence,
+//' and columns \code{phase}, \code{calls}, the number of times the phase was entered,
+//' \code{seconds}, the total wall time, and \code{bytes}, the total memory allocated.
+//'
+//' @examples
+//'
+//' \dontshow{
+//' Blackmore <- transform(Blackmore, timepoint = as.Date("2000-01-01") + round(age * 365.25),
+//'     result = cut(exercise, breaks = seq(0, 30, 2), labels = paste0("<=", seq(0, 30, 2)[-1]),
+//'         include.lowest = TRUE, ordered_result = TRUE))
+//' }
+//'
+//'  ## Continuing example from `add_transitions()`
+//' op <- options(Transition.profile = TRUE)
+//' invisible(add_transition_columns(Blackmore))
+//' transition_profile()
+//' options(op)
+//'
+//' rm(Blackmore, op)
+//'
 // [[Rcpp::export]]
-DateVector get_prev_date(DataFrame object, const char* subject = "subject", const char* timepoint = "timepoint", const char* result = "result")
+DataFrame transition_profile(bool reset = true)
 {
-//	cout << "——Rcpp::export——get_prev_date(DataFrame, const char*, const char*, const char*) subject " << subject << "; timepoint " << timepoint << "; result " << result << endl;
+//	cout << "——Rcpp::export——transition_profile(bool) reset " << reset << endl;
 	try {
-		return wrap(Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).prev_date());
+		auto& records { phase_records() };
+		const int nphases = records.size();
+		CharacterVector phase(nphases);
+		IntegerVector calls(nphases);
+		NumericVector seconds(nphases), bytes(nphases);
+		for (int x { 0 }; x < nphases; ++x) {
+			phase[x] = records[x].name;
+			calls[x] = records[x].calls;
+			seconds[x] = records[x].seconds;
+			bytes[x] = records[x].bytes;
+		}
+		if (reset)
+			records.clear();
+		return DataFrame::create(_["phase"] = phase, _["calls"] = calls, _["seconds"] = seconds, _["bytes"] = bytes);
 	} catch (exception& e) {
-		Rcerr << "Error in get_prev_date(): " << e.what() << '\n';
+		Rcerr << "Error in transition_profile(): " << e.what() << '\n';
 	} catch (std::invalid_argument& iva) {
 		Rcerr << "Error invalid argument: " << iva.what() << '\n';
 	}
-	return DateVector(0);
+	return DataFrame::create();
 }
 
 
 //' @title
-//' Find Previous Test Result for Subject
+//' Find Transitions in Data Too Large for Memory
 //'
 //' @name
-//' PreviousResult
+//' StreamTransitions
 //'
 //' @description
-//' \code{get_prev_result()} identifies the previous test result for individual subjects and timepoints
-//' in a longitudinal study.
+//' \code{write_transition_file()} writes the subject, timepoint and result columns of a data frame to
+//' a simple binary columnar file, or appends them to one, a block at a time.
 //'
-//' \code{add_prev_result()} interpolates these previous test results into a data frame for further analysis.
+//' \code{stream_transitions()} finds previous timepoints, previous results and transitions of all the
+//' rows of such a file, of any size, writing them to another such file while holding only a bounded
+//' part of the data in memory.
+//'
+//' \code{read_transition_file()} reads a range of rows of either kind of file into a data frame.
 //'
 //' @details
 //' See \code{\link{Transitions}} \emph{details}.
 //'
+//' The input file is memory-mapped and read in place. If its rows do not all fit in \code{memory},
+//' they are first partitioned by a hash of subject into temporary files in \code{tmpdir}, each small
+//' enough to sort in memory, so that all the rows of each subject fall in the same partition. Any
+//' partition left too large by subjects hashing together is split again with another hash, as often
+//' as needed. The partitions are then swept one after another on each of up to \code{threads}
+//' threads, sharing \code{memory} among them. The output file is mapped at its final size and each previous timepoint,
+//' previous result and transition is written at the row of the input to which it belongs, so the
+//' output rows are in the same order as the input rows. Values are identical to those of
+//' \code{\link{add_transition_columns}()} applied to the whole of the data.
+//'
+//' Each file begins with a 32 byte header: the eight characters \code{"TRANSCOL"}; as unsigned 32-bit
+//' integers, the format version, \code{1}, and the kind of file, \code{0} for input or \code{1} for
+//' output; as an unsigned 64-bit integer, the total number of rows; and as unsigned 32-bit integers,
+//' the number of blocks and a reserved \code{0}. Each block that follows begins with its number of
+//' rows \eqn{m} as an unsigned 64-bit integer, then for input holds \eqn{m} 32-bit integer subjects,
+//' \eqn{m} doubles of timepoints and \eqn{m} 32-bit integer results; or for output, \eqn{m} doubles of
+//' previous timepoints, \eqn{m} 32-bit integer previous results and \eqn{m} 32-bit integer
+//' transitions. Columns of 32-bit integers are padded with zeros to a multiple of eight bytes. All
+//' values are little-endian and missing values are those of \R, so files may equally be written by
+//' \code{\link{writeBin}()}. A standalone command line driver using the same C++ header,
+//' \code{include/Transition/stream.h}, is provided as \code{cli/transition-stream.cpp} in the
+//' installed package.
+//'
+//' Subjects must be of type \code{\link{integer}} or \code{\link{factor}}, and results ordered factors
+//' or binary, with the same levels in every block written; only their integer codes are stored. A
+//' single subject with more rows than fit in one thread's share of \code{memory} is nevertheless
+//' sorted and swept in memory.
+//'
 //' @family transitions
 //' @seealso
-//' \code{\link{data.frame}}, \code{\link{Dates}}, \code{\link[base:factor]{ordered factor}}.
+//' \code{\link{add_transition_columns}()}, \code{\link{writeBin}}, \code{\link{tempdir}}.
 //'
-//' @param prev_result \code{character}, name to be used for a new column to record previous result;
-//'   default \code{"prev_result"}.
+//' @param path \code{character}, path of the file to be written or read.
+//'
+//' @param append \code{\link{logical}}, whether to append the rows as a further block of an existing
+//'   file, rather than creating a new one; default \code{FALSE}.
+//'
+//' @param input \code{character}, path of a file written by \code{write_transition_file()}.
+//'
+//' @param output \code{character}, path of the file to be written, replacing any existing file.
+//'
+//' @param memory \code{\link{numeric}}, megabytes of rows to be held in memory at once, shared among
+//'   threads; default \code{256}. Each row takes 24 bytes.
+//'
+//' @param tmpdir \code{character}, directory for temporary files; default \code{""}, the session's
+//'   \code{\link{tempdir}()}.
+//'
+//' @param first \code{numeric}, the first row to read; default \code{1}.
+//'
+//' @param rows \code{numeric}, the number of rows to read; default \code{-1}, the remainder of the
+//'   file.
 //'
 //' @inheritParams Transitions
 //'
 //' @return
+//' \item{\code{write_transition_file()}}{The total number of rows in the file.}
 //'
-//' \item{\code{add_prev_result()}}{A \code{\link{data.frame}} based on \code{object}, with an added
-//'    column named as specified by argument \code{prev_result} and of type
-//'    \code{\link[base:factor]{ordered factor}} or \code{\link{integer}} depending on whether the
-//'    results are semi-quantitiative or binary.}
+//' \item{\code{stream_transitions()}}{A \code{\link{list}} of \code{rows}, the number of rows, and
+//'    \code{partitions}, the number of partitions finally swept.}
 //'
-//' \item{\code{get_prev_result()}}{An \code{\link[base:factor]{ordered factor}} of length
-//'    \code{\link{nrow}(object)}, containing the values of the previous test results ordered in the
-//'    exact sequence of the \code{subject} and \code{timepoint} in \code{object}.}
+//' \item{\code{read_transition_file()}}{A \code{\link{data.frame}} with \code{\link{integer}}
+//'    columns \code{subject} and \code{result} and \code{\link{numeric}} column \code{timepoint} for
+//'    an input file, or \code{numeric} column \code{prev_date} and \code{integer} columns
+//'    \code{prev_result} and \code{transition} for an output file.}
 //'
 //' @examples
 //'
@@ -581,87 +3990,186 @@ DateVector get_prev_date(DataFrame object, const char* subject = "subject", cons
 //' }
 //'
 //'  ## Continuing example from `add_transitions()`
-//'   # subject, timepoint and result arguments all defaults and required types
-//' Blackmore |> str()
+//'   # Write data in two blocks, as if too large to handle at once
+//' input <- tempfile(fileext = ".bin")
+//' output <- tempfile(fileext = ".bin")
+//' write_transition_file(Blackmore[1:500, ], input)
+//' write_transition_file(Blackmore[-(1:500), ], input, append = TRUE)
 //'
-//'   # Previous test results as ordered factor
-//' get_prev_result(Blackmore)
+//'   # Stream transitions through a tiny memory budget, forcing partitions
+//' stream_transitions(input, output, memory = 0.01)
 //'
-//'   # Previous test result as column of data frame
-//' (Blackmore <- add_prev_result(Blackmore)) |> head(32)
+//'   # Same as transitions found in memory
+//' streamed <- read_transition_file(output)
+//' identical(streamed$transition, get_transitions(Blackmore))
 //'
-//' rm(Blackmore)
+//' unlink(c(input, output))
+//' rm(Blackmore, input, output, streamed)
 //'
 // [[Rcpp::export]]
-DataFrame add_prev_result(
+double write_transition_file(
 	DataFrame object,
-	const char* subject = "subject",
+	const char* path,
+	CharacterVector subject = "subject",
 	const char* timepoint = "timepoint",
 	const char* result = "result",
-	const char* prev_result = "prev_result"
-)
+	bool append = false)
 {
-//	cout << "——Rcpp::export——add_prev_result(DataFrame, const char*, const char*, const char*, const char*) subject "
-//		 << subject << "; timepoint " << timepoint << "; result " << result << "; prev_result " << prev_result << endl;
+//	cout << "——Rcpp::export——write_transition_file(DataFrame, const char*, CharacterVector, const char*, const char*, bool) path " << path << endl;
 	try {
-		object.push_back(prevres_intvec(object, subject, timepoint, result), prev_result);
-		return object;
+		return Transitiondata(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result)).write_columns(path, append);
 	} catch (exception& e) {
-		Rcerr << "Error in add_prev_result(): " << e.what() << '\n';
+		Rcerr << "Error in write_transition_file(): " << e.what() << '\n';
 	} catch (std::invalid_argument& iva) {
 		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	} catch (std::runtime_error& rte) {
+		Rcerr << "Error in write_transition_file(): " << rte.what() << '\n';
 	}
-	return DataFrame::create();
+	return NA_REAL;
 }
 
 
-//' @rdname PreviousResult
+//' @rdname StreamTransitions
 // [[Rcpp::export]]
-IntegerVector get_prev_result(DataFrame object, const char* subject = "subject", const char* timepoint = "timepoint", const char* result = "result")
+List stream_transitions(
+	const char* input,
+	const char* output,
+	int cap = 0,
+	int modulate = 0,
+	double memory = 256,
+	const char* tmpdir = "",
+	int threads = 0)
 {
-//	cout << "——Rcpp::export——get_prev_result(DataFrame, const char*, const char*, const char*) subject " << subject << "; timepoint " << timepoint << "; result " << result << endl;
+//	cout << "——Rcpp::export——stream_transitions(const char*, const char*, int, int, double, const char*, int) input " << input
+//		 << "; output " << output << "; memory " << memory << endl;
 	try {
-		return prevres_intvec(object, subject, timepoint, result);
+		if (!(memory > 0))
+			throw std::invalid_argument("\"memory\" not greater than zero");
+		transition_stream::Options opt;
+		opt.cap = cap;
+		opt.modulate = modulate;
+		opt.memory = uint64_t(memory * 1048576.0);
+		opt.threads = thread_count(threads);
+		opt.tmpdir = *tmpdir ? tmpdir : as<string>(Function("tempdir")());
+		const transition_stream::Summary summary { transition_stream::stream_transitions(input, output, opt) };
+		return List::create(_["rows"] = double(summary.rows), _["partitions"] = summary.partitions);
 	} catch (exception& e) {
-		Rcerr << "Error in get_prev_result(): " << e.what() << '\n';
+		Rcerr << "Error in stream_transitions(): " << e.what() << '\n';
 	} catch (std::invalid_argument& iva) {
 		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	} catch (std::runtime_error& rte) {
+		Rcerr << "Error in stream_transitions(): " << rte.what() << '\n';
 	}
-	return IntegerVector();
+	return List();
+}
+
+
+//' @rdname StreamTransitions
+// [[Rcpp::export]]
+DataFrame read_transition_file(const char* path, double first = 1, double rows = -1)
+{
+//	cout << "——Rcpp::export——read_transition_file(const char*, double, double) path " << path << "; first " << first << "; rows " << rows << endl;
+	try {
+		const transition_stream::ColumnarFile file(path);
+		const double nrows = file.rows();
+		if (!(first >= 1) || first > nrows + 1)
+			throw std::invalid_argument("\"first\" not a row of the file");
+		const double last { rows < 0 ? nrows : std::min(nrows, first - 1 + std::floor(rows)) };
+		const R_xlen_t n = last - first + 1;
+		const bool input { file.kind() == transition_stream::input_columns };
+		NumericVector dates { new_vector<NumericVector>(n) };
+		IntegerVector ints1 { new_vector<IntegerVector>(n) }, ints2 { new_vector<IntegerVector>(n) };
+		uint64_t at { 0 }, from = first - 1;
+		R_xlen_t x { 0 };
+		for (const auto& block : file.blocks()) {
+			for (uint64_t k { from > at ? from - at : 0 }; k < block.rows && x < n; ++k, ++x) {
+				dates[x] = input ? block.timepoint()[k] : block.prev_date()[k];
+				ints1[x] = input ? block.subject()[k] : block.prev_result()[k];
+				ints2[x] = input ? block.result()[k] : block.transition()[k];
+			}
+			at += block.rows;
+		}
+		if (input)
+			return DataFrame::create(_["subject"] = ints1, _["timepoint"] = dates, _["result"] = ints2);
+		return DataFrame::create(_["prev_date"] = dates, _["prev_result"] = ints1, _["transition"] = ints2);
+	} catch (exception& e) {
+		Rcerr << "Error in read_transition_file(): " << e.what() << '\n';
+	} catch (std::invalid_argument& iva) {
+		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	} catch (std::runtime_error& rte) {
+		Rcerr << "Error in read_transition_file(): " << rte.what() << '\n';
+	}
+	return DataFrame::create();
 }
 
 
 //' @title
-//' Unique Values for Subject, Timepoint and Result
+//' Find Transitions Directly from a CSV File
 //'
 //' @name
-//' uniques
+//' CsvTransitions
 //'
 //' @description
-//' \code{uniques()} identifies unique values for subjects, timepoints and test results in
-//' longitudinal study data.
+//' \code{read_transitions_csv()} reads the subject, timepoint and result columns of a delimited text
+//' file and finds previous timepoints, previous results and transitions, without first reading the
+//' whole file into a data frame.
 //'
 //' @details
 //' See \code{\link{Transitions}} \emph{details}.
 //'
-//' Works for \code{subject} as either an \code{\link[base:vector]{integer vector}} or
-//' a \code{\link{factor}}.
+//' The file is memory-mapped and divided into chunks of about \code{chunk} megabytes at line ends.
+//' Chunks are parsed on up to \code{threads - 1} worker threads, reading only the fields of the
+//' named columns: subjects are encoded against a dictionary of the chunk, timepoints in ISO 8601
+//' form, \code{"YYYY-MM-DD"}, converted directly to day numbers and results to their positions in
+//' \code{levels}. Meanwhile the calling thread merges parsed chunks in order into a dictionary of all
+//' subjects, dividing the rows of each chunk among buckets of whole subjects, and the workers sort
+//' each merged chunk's share of every bucket while later chunks are parsed, so that parsing, merging
+//' and sorting overlap. The sorted shares of each bucket are then merged and swept on all threads.
+//' With \code{threads = 1}, each chunk is parsed, merged and sorted in turn.
+//'
+//' The first line of the file must name its columns. Fields may be quoted, with \code{""} for a
+//' quote within them, but may not contain line breaks; empty fields and \code{NA} are missing.
+//' Timepoints that are missing raise an error, as do those not in the form above, and results not in
+//' \code{levels}.
+//'
+//' The time spent parsing, merging and sorting chunks, and merging buckets and sweeping, and the rows
+//' per second overall
+//' are returned as attribute \code{"timing"}. A standalone command line driver using the same C++
+//' header, \code{include/Transition/csv.h}, is provided as \code{cli/transition-csv.cpp} in the
+//' installed package, for benchmarking outside \R.
 //'
 //' @family transitions
 //' @seealso
-//' \code{\link{data.frame}}, \code{\link{Dates}}, \code{\link[base:factor]{ordered factor}}.
+//' \code{\link{read.csv}}, \code{\link{add_transition_columns}()}, \code{\link{StreamTransitions}}.
 //'
-//' @inheritParams Transitions
+//' @param path \code{character}, path of the file to be read.
 //'
-//' @return
-//' A \code{\link{list}} of three elements
+//' @param subject \code{character}, name of the column identifying individual study subjects;
+//'   default \code{"subject"}.
 //'
-//' \item{1.}{An \code{\link[base:vector]{integer vector}} or \code{\link{factor}} of unique subject
-//'   identifications.}
+//' @param timepoint \code{character}, name of the column recording dates of testing of subjects,
+//'   as \code{"YYYY-MM-DD"}; default \code{"timepoint"}.
 //'
-//' \item{2.}{A \code{\link{vector}} of class \code{\link{Date}} of unique timepoints in the study.}
+//' @param result \code{character}, name of the column recording test results; default
+//'   \code{"result"}.
 //'
-//' \item{3.}{An \code{\link[base:factor]{ordered factor}} of unique values for results of the study.}
+//' @param levels \code{character}, the possible test results in order, or \code{NULL}, the default,
+//'   if results are integers, e.g. binary \code{0} or \code{1}.
+//'
+//' @param delimiter \code{character}, the single character separating fields; default \code{","}.
+//'
+//' @param chunk \code{\link{numeric}}, megabytes of text parsed at a time by each thread; default
+//'   \code{16}.
+//'
+//' @inheritParams Transitions
+//'
+//' @return
+//' A \code{\link{data.frame}} with a row for each line of the file after the first, in the same
+//' order, and columns \code{subject}, a \code{\link{factor}} with levels in order of first
+//' appearance; \code{timepoint} and \code{prev_date}, of class \code{\link{Date}}; \code{result} and
+//' \code{prev_result}, \code{\link[base:factor]{ordered factors}} with \code{levels} or
+//' \code{\link{integer}}; and \code{transition}, \code{integer}. Attribute \code{"timing"} is a
+//' named \code{numeric} vector of \code{parse} and \code{sweep} seconds, and \code{rows_per_sec}.
 //'
 //' @examples
 //'
@@ -672,37 +4180,57 @@ IntegerVector get_prev_result(DataFrame object, const char* subject = "subject",
 //' }
 //'
 //'  ## Continuing example from `add_transitions()`
-//'   # subject, timepoint and result arguments all defaults and required types
-//'   # (native subject is factor)
-//' uniques(Blackmore)
-//'   #
-//' Blackmore <- transform(Blackmore, subject = as.integer(subject))
-//'   # subject now as integer
-//' Blackmore |> str()
-//' uniques(Blackmore)
+//' csv <- tempfile(fileext = ".csv")
+//' write.csv(Blackmore, csv, row.names = FALSE)
 //'
-//' rm(Blackmore)
+//'   # Transitions straight from the file
+//' (read <- read_transitions_csv(csv, levels = levels(Blackmore$result))) |> head(10)
+//' attr(read, "timing")
+//'
+//'   # Same as transitions found from the data frame
+//' identical(read$transition, get_transitions(Blackmore))
+//'
+//' unlink(csv)
+//' rm(Blackmore, csv, read)
 //'
 // [[Rcpp::export]]
-List uniques(DataFrame object, const char* subject = "subject", const char* timepoint = "timepoint", const char* result = "result")
+DataFrame read_transitions_csv(
+	const char* path,
+	const char* subject = "subject",
+	const char* timepoint = "timepoint",
+	const char* result = "result",
+	Nullable<CharacterVector> levels = R_NilValue,
+	const char* delimiter = ",",
+	int cap = 0,
+	int modulate = 0,
+	double chunk = 16,
+	int threads = 0)
 {
-//	cout << "——Rcpp::export——uniques(DataFrame)\n";
+//	cout << "——Rcpp::export——read_transitions_csv(const char*, const char*, const char*, const char*, Nullable<CharacterVector>, const char*, int, int, double, int) path "
+//		 << path << "; chunk " << chunk << "; threads " << threads << endl;
 	try {
-		Transitiondata td(object, colpos(object, subject), colpos(object, timepoint), colpos(object, result));
-		IntegerVector subvec(wrap(td.unique_sub()));
-		RObject subcol{ object[colpos(object, subject)] };
-		if (subcol.inherits("factor")) {
-			subvec.attr("class") = string { "factor" };			
-			subvec.attr("levels") = subcol.attr("levels");
-		}
-		IntegerVector rltvec(wrap(td.unique_test()));
-		rltvec.attr("class") = CharacterVector::create("factor", "ordered");
-		rltvec.attr("levels") = (RObject { object[colpos(object, result)] }).attr("levels");
-		return List::create(_[subject] = subvec, _[timepoint] = td.unique_date(), _[result] = rltvec);
+		if (std::strlen(delimiter) != 1)
+			throw std::invalid_argument("\"delimiter\" not a single character");
+		if (!(chunk > 0))
+			throw std::invalid_argument("\"chunk\" not greater than zero");
+		transition_csv::Options opt;
+		opt.subject = subject;
+		opt.timepoint = timepoint;
+		opt.result = result;
+		if (levels.isNotNull())
+			opt.levels = as<vector<string>>(levels.get());
+		opt.delimiter = *delimiter;
+		opt.cap = cap;
+		opt.modulate = modulate;
+		opt.chunk = uint64_t(chunk * 1048576.0);
+		opt.threads = thread_count(threads);
+		return csv_transitions(path, opt);
 	} catch (exception& e) {
-		Rcerr << "Error in uniques(): " << e.what() << '\n';
+		Rcerr << "Error in read_transitions_csv(): " << e.what() << '\n';
 	} catch (std::invalid_argument& iva) {
 		Rcerr << "Error invalid argument: " << iva.what() << '\n';
+	} catch (std::runtime_error& rte) {
+		Rcerr << "Error in read_transitions_csv(): " << rte.what() << '\n';
 	}
-	return List::create();
+	return DataFrame::create();
 }
@@ -19,62 +19,262 @@ std::ostream& operator<< (std::ostream&, const Demangler&);
 
 #endif // #ifdef DEBUG
 
+// Profiling
+struct PhaseRecord;
+std::vector<PhaseRecord>& phase_records();
+bool profiling();
+
+class Phase {
+	std::string name;
+	double bytes;
+	const bool on;
+	std::chrono::steady_clock::time_point start;
+public:
+	explicit Phase(const char*, double = 0);
+	~Phase();
+	Phase(const Phase&) = delete;
+	Phase& operator=(const Phase&) = delete;
+	void add_bytes(double more) { bytes += more; }
+};
+
+template<class V>
+inline V new_vector(R_xlen_t);
+
 // Utility
 template<class T, class U> 
 inline std::vector<U> get_vec_attr(const T&, const char*);
 template<class T>
 inline std::string str_tolower(std::string);
 int colpos(const DataFrame, const char*);
+bool skip_na(const char*);
+inline IntegerMatrix code_matrix(const Nullable<IntegerMatrix>&);
+std::vector<int> colpos(const DataFrame, const CharacterVector&);
+inline void result_attrs(IntegerVector&, const IntegerVector&);
+inline void date_attrs(NumericVector&, const NumericVector&);
+std::vector<std::string> transition_names(const CharacterVector&, const CharacterVector&);
+inline RObject select_codes(SEXP, const std::vector<int>&);
+IntegerVector encode_strings(SEXP, CharacterVector&);
+inline void same_levels(const RObject&, const RObject&, const char*);
+DataFrame append_columns(const DataFrame&, const List&);
+template<class T>
+std::vector<T> get_unique(const T*, const T*);
 template<class T>
-std::vector<T> get_unique(const std::vector<T>);
-inline int adjust(int, int, int);
+void sorted_runs(const std::vector<T>&, std::vector<T>&, std::vector<int>&);
+inline void unique_codes(const int*, const int*, int, int, std::vector<int>&, std::vector<int>&);
+inline void unique_days(const double*, const double*, std::vector<double>&, std::vector<int>&);
+inline DataFrame value_counts(const RObject&, const std::vector<int>&, const std::string&);
+using transition_sweep::adjust;
+struct Divisor;
+template<bool Cap, bool Mod>
+struct Adjuster;
+template<bool Forward, bool Cap, bool Mod>
+inline void adjust_range(const int* __restrict, int* __restrict, R_xlen_t, Adjuster<Cap, Mod>);
+template<bool Forward>
+inline void adjust_kernel(const int*, int*, R_xlen_t, int, int);
+void adjust_transitions(const int*, int*, R_xlen_t, int, int, bool);
+struct Codebook { const int* codes { nullptr }; uint32_t nlevels { 0 }, offset { 0 }; };
+template<bool Forward>
+inline void code_range(const int* __restrict, int* __restrict, R_xlen_t, const int* __restrict, uint32_t, uint32_t);
+void code_transitions(const int* __restrict, int* __restrict, R_xlen_t, const Codebook&, bool);
+inline std::pair<int, int> year_month(int64_t);
+std::vector<int> local_months(const NumericVector&);
+
+// Index
+struct Permuted { const int* order; int operator()(int k) const { return order[k]; } };
+struct Ascending { int operator()(int k) const { return k; } };
+struct Descending { int last; int operator()(int k) const { return last - k; } };
+using transition_sweep::KeepAll;
+struct Window {
+	double min { 0 }, max { std::numeric_limits<double>::infinity() };
+	bool all() const { return min <= 0 && std::isinf(max); }
+	bool excludes(double gap) const { return gap < min || gap > max; }
+};
+Window gap_window(double, double);
+int presorted(const int*, const double*, int);
+bool radix_order(const int*, const double*, std::vector<int>&, Phase&);
+std::vector<int> order_rows(const int*, const double*, int);
+template<class Rows, class K>
+inline int kept_run(const int*, const double*, Rows, int, int, int&, K);
+template<class Rows, class F, class K>
+void sweep_runs(const int*, const double*, Rows, F, int, int, K);
+template<class Rows, class F>
+void sweep_runs(const int*, const double*, Rows, F, int, int);
+template<class Rows, class F>
+void sweep_adjacent(const int*, const double*, Rows, F, int, int);
+template<class Rows, class F, class K>
+void sweep_adjacent(const int*, const double*, Rows, F, int, int, K);
+template<class Rows, class F>
+void sweep_lags(const int*, const double*, Rows, F, int, int, int);
+template<class Rows, class B>
+void for_blocks(const int*, Rows, int, B, int);
+template<class Rows, class F, class K>
+void sweep_parallel(const int*, const double*, Rows, int, F, int, K);
+template<class Rows>
+std::pair<int, int> subject_span(const int*, Rows, int, int);
+int thread_count(int);
 
 /// Class Transitiondata
 
 class Transitiondata {
 	DataFrame df;
+	const std::vector<int> idcols;
+	const int idcol, datecol, testcol;
+	int nrows = df.nrows();
+	CharacterVector idlabels;
+	List idkeys;
 	const IntegerVector id;
-	const DateVector testdate;
+	const NumericVector testdate;
 	const IntegerVector testresult;
-	int nrows = df.nrows();
+	const int sorted;
+	const std::vector<int> order;
+	IntegerVector key_codes(int, CharacterVector&);
+	IntegerVector subject_codes();
 	template<typename T>
 	T typechecker(int, int);
+	template<class G>
+	void visit_rows(G) const;
+	template<class F, class K = KeepAll>
+	void sweep(F, int, K = K()) const;
+	template<class M>
+	void sweep_blocks(M, int) const;
+	template<class F>
+	void sweep_both(F, int) const;
+	template<class F, class K>
+	void sweep_both(F, int, K) const;
+	template<class F>
+	void sweep_within(F, const Window&, int) const;
+	template<class F, class K>
+	void sweep_within(F, const Window&, int, K) const;
+	template<class F>
+	void sweep_both_within(F, const Window&, int) const;
+	template<class F, class K>
+	void sweep_both_within(F, const Window&, int, K) const;
+	template<class F>
+	auto within(F, const Window&) const;
+	template<class F>
+	auto within_both(F, const Window&) const;
+	template<class F>
+	void sweep_lagged(F, int, int) const;
+	template<int RTYPE>
+	List lagged(const IntegerVector&, const Vector<RTYPE>&, int) const;
+	RObject subject_values(const std::vector<int>&) const;
+	List subject_columns(const std::vector<int>&) const;
+	int positive_level(const char*) const;
+	Codebook codebook(const IntegerMatrix&, const IntegerVector&, int, int) const;
+	void transitions_of(const int*, int*, int, int, bool, int, bool, const Window&, const Codebook& = Codebook()) const;
+	DataFrame state_frame(const std::vector<int>&, const std::vector<double>&, const std::vector<int>&) const;
 
 public:
-	explicit Transitiondata(DataFrame _df, int idcol, int datecol, int testcol) :
-		df(_df), id(typechecker<IntegerVector>(idcol, 1)), testdate(typechecker<DateVector>(datecol, 2)), testresult(typechecker<IntegerVector>(testcol, 3))
+	explicit Transitiondata(DataFrame _df, const std::vector<int>& idcols, int datecol, int testcol) :
+		df(_df), idcols(idcols), idcol(idcols.at(0)), datecol(datecol), testcol(testcol), id(subject_codes()), testdate(typechecker<NumericVector>(datecol, 2)), testresult(typechecker<IntegerVector>(testcol, 3)),
+		sorted(::presorted(id.begin(), testdate.begin(), nrows)),
+		order(sorted ? std::vector<int>() : order_rows(id.begin(), testdate.begin(), nrows))
 		{
-//			std::cout << "§Transitiondata::Transitiondata(const DataFrame, int, int, int) "; _ctrsgn(typeid(*this));
+//			std::cout << "§Transitiondata::Transitiondata(const DataFrame, const std::vector<int>&, int, int) "; _ctrsgn(typeid(*this));
 		}
 
+	explicit Transitiondata(DataFrame _df, int idcol, int datecol, int testcol) :
+		Transitiondata(_df, std::vector<int>{ idcol }, datecol, testcol) {}
+
 	~Transitiondata() = default;
 //	~Transitiondata() { std::cout << "§Transitiondata::~Transitiondata() "; _ctrsgn(typeid(*this), true); }
 
-	std::vector<int> unique_sub() const { return get_unique(as<std::vector<int>>(id)); }
-	DateVector unique_date() const { return wrap(get_unique(as<std::vector<double>>(testdate))); }
-	std::vector<int> unique_test() const { return get_unique(as<std::vector<int>>(testresult)); }
+	List uniques(bool = false) const;
+	const char* presorted() const;
+	const IntegerVector& results() const { return testresult; }
+	bool character_subjects() const { return STRSXP == TYPEOF(df[idcol]); }
+	bool composite() const { return idcols.size() > 1; }
+
+	NumericVector prev_date(int = 1) const;
+	IntegerVector prev_result(int = 1) const;
+	RObject prev_dates(const IntegerVector&, int = 1) const;
+	RObject prev_results(const IntegerVector&, int = 1) const;
+	NumericVector next_date(int = 1) const;
+	IntegerVector next_result(int = 1) const;
+	DataFrame add_transition(const char* colname, int, int, bool = false, int = 1, bool = false, const Window& = Window(), const IntegerMatrix& = IntegerMatrix());
+	IntegerVector get_transition(int, int, bool = false, int = 1, bool = false, const Window& = Window(), const IntegerMatrix& = IntegerMatrix()) const;
+	DataFrame add_transitions(const std::vector<int>&, const std::vector<std::string>&, int, int, bool = false, int = 1, bool = false, const Window& = Window(),
+		const IntegerMatrix& = IntegerMatrix());
+	List get_transitions(const std::vector<int>&, int, int, bool = false, int = 1, bool = false, const Window& = Window(), const IntegerMatrix& = IntegerMatrix());
+	DataFrame add_columns(const char*, const char*, const char*, const char*, const char*, const char*, const char*, int, int, bool = false, int = 1, bool = false,
+		const Window& = Window()) const;
+	IntegerVector transition_matrix(const char*, int = 1) const;
+	DataFrame subject_summary(const char*, int = 1) const;
+	DataFrame episodes(int = 1) const;
+	std::vector<int> subject_rows(int) const;
+	int last_row(int) const;
+	DataFrame state() const;
+	double write_columns(const char*, bool) const;
+	List update(const Transitiondata&, const Transitiondata*, const char*, const char*, const char*, int, int) const;
+};
+
+
+/// Class Reference
+
+class Reference {
+	const IntegerVector id;
+	const NumericVector testdate;
+	const IntegerVector testresult;
+	int nrows = id.size();
+
+public:
+	explicit Reference(DataFrame df, int idcol, int datecol, int testcol) :
+		id(df[idcol]), testdate(df[datecol]), testresult(df[testcol]) {}
 
 	int get_result(int, double) const;
 	std::vector<double> get_id_dates(int) const;
 	double get_prevdate(int, double) const;
 	std::vector<double> prev_date() const;
 	std::vector<int> prev_result() const;
-	DataFrame add_transition(const char* colname, int, int);
 	std::vector<int> get_transition(int, int) const;
+	double get_lagdate(int, double, int) const;
+	DataFrame reference(int, int, int = 1) const;
 };
 
 
 // Auxilliary
-inline IntegerVector prevres_intvec(DataFrame, const char*, const char*, const char*);
+inline IntegerVector prevres_intvec(const Transitiondata&, int);
+inline IntegerVector prevres_intvec(DataFrame, const CharacterVector&, const char*, const char*, int);
+inline IntegerVector nextres_intvec(const Transitiondata&, int);
+inline RObject lag_frame(List, const IntegerVector&);
+Transitiondata& prepared_data(SEXP);
+
+// Synthetic data
+DataFrame synthetic(int, int, int, const char*, bool);
+
+// Delimited text
+DataFrame csv_transitions(const char*, const transition_csv::Options&);
 
 
 // Exported
-DataFrame add_transitions(DataFrame object, const char* subject, const char* timepoint, const char* result, const char* transition, int cap, int modulator); 
-IntegerVector get_transitions(DataFrame object, const char* subject, const char* timepoint, const char* result, int cap, int modulator); 
-DataFrame add_prev_date(DataFrame object, const char* subject, const char* timepoint, const char* result, const char* prev_date);
-DateVector get_prev_date(DataFrame object, const char* subject, const char* timepoint, const char* result);
-DataFrame add_prev_result(DataFrame object, const char* subject, const char* timepoint, const char* result, const char* prev_result);
-IntegerVector get_prev_result(DataFrame object, const char* subject, const char* timepoint, const char* result);
-List uniques(DataFrame object, const char* subject, const char* timepoint, const char* result);
+DataFrame add_transitions(DataFrame object, CharacterVector subject, const char* timepoint, CharacterVector result, CharacterVector transition, int cap, int modulator, bool forward, const char* na, double min_gap, double max_gap, Nullable<IntegerMatrix> codes, int threads); 
+RObject get_transitions(DataFrame object, CharacterVector subject, const char* timepoint, CharacterVector result, int cap, int modulator, bool forward, const char* na, double min_gap, double max_gap, Nullable<IntegerMatrix> codes, int threads); 
+DataFrame add_prev_date(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, const char* prev_date, int threads);
+RObject get_prev_date(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, IntegerVector lag, int threads);
+DataFrame add_prev_result(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, const char* prev_result, int threads);
+RObject get_prev_result(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, IntegerVector lag, int threads);
+NumericVector get_next_date(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, int threads);
+IntegerVector get_next_result(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, int threads);
+List uniques(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, bool counts);
+SEXP prepare_transitions(DataFrame object, CharacterVector subject, const char* timepoint, const char* result);
+IntegerVector get_transitions_prepared(SEXP prepared, int cap, int modulate, bool forward, const char* na, double min_gap, double max_gap, Nullable<IntegerMatrix> codes, int threads);
+RObject get_prev_date_prepared(SEXP prepared, IntegerVector lag, int threads);
+RObject get_prev_result_prepared(SEXP prepared, IntegerVector lag, int threads);
+NumericVector get_next_date_prepared(SEXP prepared, int threads);
+IntegerVector get_next_result_prepared(SEXP prepared, int threads);
+List uniques_prepared(SEXP prepared, bool counts);
+DataFrame transition_state(SEXP prepared);
+IntegerVector transition_matrix(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, const char* by, int threads);
+List update_transitions(DataFrame state, DataFrame object, const char* subject, const char* timepoint, const char* result, const char* prev_date, const char* prev_result, const char* transition, int cap, int modulate, SEXP history);
+DataFrame transition_profile(bool reset);
+DataFrame reference_transitions(DataFrame object, const char* subject, const char* timepoint, const char* result, int cap, int modulate, int lag);
+DataFrame synthetic_study(int subjects, int visits, int levels, const char* order, bool unbalanced);
+DataFrame subject_summary(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, const char* positive, int threads);
+DataFrame transition_episodes(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, int threads);
+double write_transition_file(DataFrame object, const char* path, CharacterVector subject, const char* timepoint, const char* result, bool append);
+List stream_transitions(const char* input, const char* output, int cap, int modulate, double memory, const char* tmpdir, int threads);
+DataFrame read_transition_file(const char* path, double first, double rows);
+DataFrame read_transitions_csv(const char* path, const char* subject, const char* timepoint, const char* result, Nullable<CharacterVector> levels, const char* delimiter, int cap, int modulate, double chunk, int threads);
+DataFrame add_transition_columns(DataFrame object, CharacterVector subject, const char* timepoint, const char* result, const char* prev_date, const char* prev_result, const char* transition, const char* interval, const char* next_date, const char* next_result, const char* days, int cap, int modulate, bool forward, const char* na, double min_gap, double max_gap, int threads);
 
 #endif  // TRANSITION_H